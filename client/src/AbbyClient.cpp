@@ -72,22 +72,27 @@ std::string AbbyClient::sendCommand(const std::string& cmd) {
         return "ERROR: Send failed";
     }
 
-    // Read response
-    char buffer[1024] = {0};
-    ssize_t received = ::read(m_socket, buffer, 1023);
-    if (received < 0) {
-        std::cerr << "[AbbyClient] Read timeout or error" << std::endl;
-        disconnect();
-        return "ERROR: Read failed"; 
+    // Read response: the daemon closes the connection after it, so read to the end
+    // (listings such as 'shader list' do not fit one read)
+    std::string result;
+    char buffer[1024];
+    for (;;) {
+        ssize_t received = ::read(m_socket, buffer, sizeof(buffer));
+        if (received < 0) {
+            if (!result.empty()) break;
+            std::cerr << "[AbbyClient] Read timeout or error" << std::endl;
+            disconnect();
+            return "ERROR: Read failed"; 
+        }
+        if (received == 0) break;
+        result.append(buffer, received);
     }
     
-    if (received == 0) {
+    if (result.empty()) {
         // std::cerr << "[AbbyClient] Server closed connection" << std::endl;
         disconnect();
         return "ERROR: Connection closed by daemon";
     }
-
-    std::string result(buffer, received);
     
     // Trim
     while (!result.empty() && (result.back() == '\n' || result.back() == '\r')) result.pop_back();
@@ -1,16 +1,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+
+class PiraReader;
 
 namespace Abby {
 
+// Stream description of the currently open track
+struct TrackInfo {
+    bool rawPcm = false;        // PIRA v3 PCM: feed straight to the device
+    unsigned channels = 0;      // Only set for raw PCM
+    unsigned sampleRate = 0;    // Only set for raw PCM
+};
+
 class AbbyCrypt {
 public:
     // Decrypt entire file to memory (legacy/compatibility)
     static std::vector<unsigned char> decryptTrackToMemory(const std::string& piraPath);
     
-    // Encrypt a track file
-    static bool encryptTrackFile(const std::string& inputPath, const std::string& outputPath, const std::string& targetSerial);
+    // Encrypt a track file; a non-empty analysis blob is embedded (PIRA v3)
+    static bool encryptTrackFile(const std::string& inputPath, const std::string& outputPath, const std::string& targetSerial,
+                                 const std::vector<unsigned char>& analysis = {});
+    
+    // Encrypt already decoded s16 PCM (PIRA v3)
+    static bool encryptPcmTrack(const std::vector<unsigned char>& pcm, unsigned channels, unsigned sampleRate, const std::string& outputPath, const std::string& targetSerial,
+                                const std::vector<unsigned char>& analysis = {});
     
     // Get hardware serial
     static std::string getHardwareSerial();
@@ -22,6 +37,30 @@ public:
     static size_t getTotalChunks();
     static size_t getCurrentChunk();
     static void seekToChunk(size_t chunk);
+    static TrackInfo getTrackInfo();
+};
+
+// Independent streaming reader: one per player, several may be open at once
+class TrackStream {
+public:
+    TrackStream();
+    ~TrackStream();
+    TrackStream(const TrackStream&) = delete;
+    TrackStream& operator=(const TrackStream&) = delete;
+
+    bool open(const std::string& path, const std::string& serial);
+    std::vector<unsigned char> decryptNextChunk();
+    void close();
+    size_t getTotalChunks() const;
+    size_t getCurrentChunk() const;
+    void seekToChunk(size_t chunk);
+    TrackInfo getTrackInfo() const;
+    
+    // Precomputed analysis embedded at encryption time; empty if the file has none
+    const std::vector<unsigned char>& getAnalysis() const;
+
+private:
+    std::unique_ptr<PiraReader> m_reader;
 };
 
 }
@@ -1,39 +1,86 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <fstream>
 #include <cstdint>
 
 // PIRA v2 Format - Chunked streaming encryption
 // Chunk size: 1 second @ 44.1kHz stereo 16-bit = ~176KB
 #define CHUNK_SIZE_BYTES 176400  // 1 second of audio
 
+// PIRA v3 adds a stream description so the player can skip ma_decoder
+// for tracks that were decoded to PCM at encryption time.
+enum PiraCodec : uint8_t {
+    PIRA_CODEC_ENCODED = 0,  // Compressed stream (MP3 etc), needs ma_decoder
+    PIRA_CODEC_PCM_S16 = 1   // Interleaved signed 16-bit little-endian PCM
+};
+
+struct PiraStreamInfo {
+    uint8_t version = 0;
+    uint8_t codec = PIRA_CODEC_ENCODED;
+    uint8_t channels = 0;       // Only meaningful for PCM
+    uint32_t sampleRate = 0;    // Only meaningful for PCM
+};
+
 struct ChunkMetadata {
     std::vector<unsigned char> iv;   // 12 bytes
     std::vector<unsigned char> tag;  // 16 bytes
     size_t dataSize;                  // actual chunk data size
 };
 
+// Streaming reader for one open PIRA file. Each player owns its own
+// instance so several tracks can be decrypted concurrently.
+class PiraReader {
+public:
+    bool open(const std::string& sourcePath, const std::string& serial);
+    std::vector<unsigned char> decryptNextChunk();
+    void close();
+    size_t getTotalChunks() const { return totalChunks; }
+    size_t getCurrentChunk() const { return currentChunkIndex; }
+    void seekToChunk(size_t chunkIndex);
+    PiraStreamInfo getStreamInfo() const { return streamInfo; }
+    
+    // Precomputed analysis section (v3, optional); empty when absent
+    const std::vector<unsigned char>& getAnalysis() const { return analysis; }
+    
+private:
+    std::ifstream currentFile;
+    std::vector<unsigned char> currentKey;
+    size_t totalChunks = 0;
+    size_t currentChunkIndex = 0;
+    uint32_t storedChunkSize = 0;
+    uint32_t dataOffset = 0;
+    PiraStreamInfo streamInfo;
+    std::vector<unsigned char> analysis;
+    
+    bool readSections();
+};
+
 class FileHandler {
 public:
-    // PIRA v2: Chunked encryption for streaming
-    static bool encryptFile(const std::string& sourcePath, const std::string& destPath, const std::string& serial);
+    // PIRA v2: Chunked encryption for streaming (v3 when an analysis section is attached)
+    static bool encryptFile(const std::string& sourcePath, const std::string& destPath, const std::string& serial,
+                            const std::vector<unsigned char>& analysis = {});
+    
+    // PIRA v3: Chunked encryption of raw s16 PCM
+    static bool encryptPcm(const std::vector<unsigned char>& pcm, uint8_t channels, uint32_t sampleRate, const std::string& destPath, const std::string& serial,
+                           const std::vector<unsigned char>& analysis = {});
     
-    // Streaming decryption
+    // Streaming decryption (process-wide reader, kept for existing callers)
     static bool openEncryptedFile(const std::string& sourcePath, const std::string& serial);
     static std::vector<unsigned char> decryptNextChunk();
     static void closeEncryptedFile();
     static size_t getTotalChunks();
     static size_t getCurrentChunk();
     static void seekToChunk(size_t chunkIndex);
+    static PiraStreamInfo getStreamInfo();
     
     // Legacy: Decrypt entire file to memory (for compatibility during transition)
     static std::vector<unsigned char> decryptToMemory(const std::string& sourcePath, const std::string& serial);
     
 private:
-    static std::ifstream currentFile;
-    static std::string currentSerial;
-    static size_t totalChunks;
-    static size_t currentChunkIndex;
-    static uint32_t storedChunkSize;
-    static std::vector<ChunkMetadata> chunkMetadata;
+    static bool writeChunks(const std::vector<unsigned char>& data, const std::string& destPath, const std::string& serial, const PiraStreamInfo& info,
+                            const std::vector<unsigned char>& analysis);
+
+    static PiraReader defaultReader;
 };
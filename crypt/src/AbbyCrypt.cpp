@@ -8,8 +8,14 @@ std::vector<unsigned char> AbbyCrypt::decryptTrackToMemory(const std::string& pi
     return FileHandler::decryptToMemory(piraPath, HardwareID::getSerial());
 }
 
-bool AbbyCrypt::encryptTrackFile(const std::string& inputPath, const std::string& outputPath, const std::string& targetSerial) {
-    return FileHandler::encryptFile(inputPath, outputPath, targetSerial);
+bool AbbyCrypt::encryptTrackFile(const std::string& inputPath, const std::string& outputPath, const std::string& targetSerial,
+                                 const std::vector<unsigned char>& analysis) {
+    return FileHandler::encryptFile(inputPath, outputPath, targetSerial, analysis);
+}
+
+bool AbbyCrypt::encryptPcmTrack(const std::vector<unsigned char>& pcm, unsigned channels, unsigned sampleRate, const std::string& outputPath, const std::string& targetSerial,
+                                const std::vector<unsigned char>& analysis) {
+    return FileHandler::encryptPcm(pcm, static_cast<uint8_t>(channels), sampleRate, outputPath, targetSerial, analysis);
 }
 
 std::string AbbyCrypt::getHardwareSerial() {
@@ -41,4 +47,54 @@ void AbbyCrypt::seekToChunk(size_t chunk) {
     FileHandler::seekToChunk(chunk);
 }
 
+static TrackInfo toTrackInfo(const PiraStreamInfo& stream) {
+    TrackInfo info;
+    info.rawPcm = (stream.codec == PIRA_CODEC_PCM_S16);
+    if (info.rawPcm) {
+        info.channels = stream.channels;
+        info.sampleRate = stream.sampleRate;
+    }
+    return info;
+}
+
+TrackInfo AbbyCrypt::getTrackInfo() {
+    return toTrackInfo(FileHandler::getStreamInfo());
+}
+
+TrackStream::TrackStream() : m_reader(new PiraReader()) {}
+
+TrackStream::~TrackStream() = default;
+
+bool TrackStream::open(const std::string& path, const std::string& serial) {
+    return m_reader->open(path, serial);
+}
+
+std::vector<unsigned char> TrackStream::decryptNextChunk() {
+    return m_reader->decryptNextChunk();
+}
+
+void TrackStream::close() {
+    m_reader->close();
+}
+
+size_t TrackStream::getTotalChunks() const {
+    return m_reader->getTotalChunks();
+}
+
+size_t TrackStream::getCurrentChunk() const {
+    return m_reader->getCurrentChunk();
+}
+
+void TrackStream::seekToChunk(size_t chunk) {
+    m_reader->seekToChunk(chunk);
+}
+
+TrackInfo TrackStream::getTrackInfo() const {
+    return toTrackInfo(m_reader->getStreamInfo());
+}
+
+const std::vector<unsigned char>& TrackStream::getAnalysis() const {
+    return m_reader->getAnalysis();
+}
+
 }
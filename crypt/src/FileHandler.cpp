@@ -8,12 +8,7 @@
 #include <algorithm>
 
 // Static members
-std::ifstream FileHandler::currentFile;
-std::string FileHandler::currentSerial;
-size_t FileHandler::totalChunks = 0;
-size_t FileHandler::currentChunkIndex = 0;
-uint32_t FileHandler::storedChunkSize = 0;
-std::vector<ChunkMetadata> FileHandler::chunkMetadata;
+PiraReader FileHandler::defaultReader;
 
 // PIRA v2 Format:
 // [0-3]   Magic "PIRA"
@@ -21,12 +16,31 @@ std::vector<ChunkMetadata> FileHandler::chunkMetadata;
 // [5-8]   Total chunks (uint32_t)
 // [9-12]  Chunk size (uint32_t)
 //
+// PIRA v3 Format (same chunk layout, extended header):
+// [0-3]   Magic "PIRA"
+// [4]     Version 0x03
+// [5-8]   Total chunks (uint32_t)
+// [9-12]  Chunk size (uint32_t)
+// [13]    Codec (PiraCodec)
+// [14]    Channels
+// [15-18] Sample rate (uint32_t)
+// [19-22] Offset of the first chunk (uint32_t)
+// [23-..] Optional sections up to the first chunk, skipped by older readers:
+//         [0-3] Section tag ("ANLZ" = precomputed analysis)
+//         [4-7] Section size after these 8 bytes (uint32_t)
+//         [8-..] IV (12 bytes), Tag (16 bytes), encrypted payload
+//
 // For each chunk:
 // [0-11]  IV (12 bytes)
 // [12-27] Tag (16 bytes)
 // [28-N]  Encrypted chunk data
 
-bool FileHandler::encryptFile(const std::string& sourcePath, const std::string& destPath, const std::string& serial) {
+static const size_t PIRA_V2_HEADER_SIZE = 13;
+static const size_t PIRA_V3_HEADER_SIZE = 23;
+static const char PIRA_SECTION_ANALYSIS[4] = { 'A', 'N', 'L', 'Z' };
+
+bool FileHandler::encryptFile(const std::string& sourcePath, const std::string& destPath, const std::string& serial,
+                              const std::vector<unsigned char>& analysis) {
     // 1. Read Input
     std::ifstream inFile(sourcePath, std::ios::binary);
     if (!inFile) {
@@ -42,23 +56,48 @@ bool FileHandler::encryptFile(const std::string& sourcePath, const std::string&
         return false;
     }
     
-    // 2. Calculate chunks
+    // Compressed tracks stay on v2 so older players can still read them,
+    // unless there is an analysis section to carry
+    PiraStreamInfo info;
+    info.version = analysis.empty() ? 0x02 : 0x03;
+    info.codec = PIRA_CODEC_ENCODED;
+    return writeChunks(data, destPath, serial, info, analysis);
+}
+
+bool FileHandler::encryptPcm(const std::vector<unsigned char>& pcm, uint8_t channels, uint32_t sampleRate, const std::string& destPath, const std::string& serial,
+                             const std::vector<unsigned char>& analysis) {
+    if (pcm.empty() || channels == 0 || sampleRate == 0) {
+        std::cerr << "Error: Invalid PCM input" << std::endl;
+        return false;
+    }
+    
+    PiraStreamInfo info;
+    info.version = 0x03;
+    info.codec = PIRA_CODEC_PCM_S16;
+    info.channels = channels;
+    info.sampleRate = sampleRate;
+    return writeChunks(pcm, destPath, serial, info, analysis);
+}
+
+bool FileHandler::writeChunks(const std::vector<unsigned char>& data, const std::string& destPath, const std::string& serial, const PiraStreamInfo& info,
+                              const std::vector<unsigned char>& analysis) {
+    // 1. Calculate chunks
     size_t numChunks = (data.size() + CHUNK_SIZE_BYTES - 1) / CHUNK_SIZE_BYTES;
     
     std::cout << "Encrypting " << data.size() << " bytes in " << numChunks << " chunks..." << std::endl;
     
-    // 3. Derive key once
+    // 2. Derive key once
     std::vector<unsigned char> key = CryptoEngine::deriveKey(serial);
     
-    // 4. Open output file
+    // 3. Open output file
     std::ofstream outFile(destPath, std::ios::binary);
     if (!outFile) return false;
     
-    // 5. Write header
+    // 4. Write header
     const char magic[] = "PIRA";
     outFile.write(magic, 4);
     
-    char version = 0x02;
+    char version = static_cast<char>(info.version);
     outFile.write(&version, 1);
     
     uint32_t numChunksU32 = static_cast<uint32_t>(numChunks);
@@ -66,7 +105,36 @@ bool FileHandler::encryptFile(const std::string& sourcePath, const std::string&
     outFile.write(reinterpret_cast<const char*>(&numChunksU32), sizeof(uint32_t));
     outFile.write(reinterpret_cast<const char*>(&chunkSizeU32), sizeof(uint32_t));
     
-    // 6. Encrypt and write each chunk
+    if (info.version >= 0x03) {
+        std::vector<unsigned char> analysisIv, analysisTag, analysisEncrypted;
+        if (!analysis.empty()) {
+            analysisEncrypted = CryptoEngine::encrypt(analysis, key, analysisIv, analysisTag);
+            if (analysisEncrypted.empty()) {
+                std::cerr << "Error: Analysis section encryption failed" << std::endl;
+                return false;
+            }
+        }
+        uint32_t sectionSize = static_cast<uint32_t>(analysisIv.size() + analysisTag.size() + analysisEncrypted.size());
+        
+        char codec = static_cast<char>(info.codec);
+        char channels = static_cast<char>(info.channels);
+        uint32_t firstChunk = PIRA_V3_HEADER_SIZE + (analysis.empty() ? 0 : 8 + sectionSize);
+        outFile.write(&codec, 1);
+        outFile.write(&channels, 1);
+        outFile.write(reinterpret_cast<const char*>(&info.sampleRate), sizeof(uint32_t));
+        outFile.write(reinterpret_cast<const char*>(&firstChunk), sizeof(uint32_t));
+        
+        if (!analysis.empty()) {
+            outFile.write(PIRA_SECTION_ANALYSIS, 4);
+            outFile.write(reinterpret_cast<const char*>(&sectionSize), sizeof(uint32_t));
+            outFile.write(reinterpret_cast<const char*>(analysisIv.data()), analysisIv.size());
+            outFile.write(reinterpret_cast<const char*>(analysisTag.data()), analysisTag.size());
+            outFile.write(reinterpret_cast<const char*>(analysisEncrypted.data()), analysisEncrypted.size());
+            std::cout << "Analysis section: " << analysis.size() << " bytes" << std::endl;
+        }
+    }
+    
+    // 5. Encrypt and write each chunk
     for (size_t i = 0; i < numChunks; ++i) {
         size_t offset = i * CHUNK_SIZE_BYTES;
         size_t chunkSize = std::min(static_cast<size_t>(CHUNK_SIZE_BYTES), data.size() - offset);
@@ -92,30 +160,29 @@ bool FileHandler::encryptFile(const std::string& sourcePath, const std::string&
     return true;
 }
 
-bool FileHandler::openEncryptedFile(const std::string& sourcePath, const std::string& serial) {
-    closeEncryptedFile();
+bool PiraReader::open(const std::string& sourcePath, const std::string& serial) {
+    close();
     
     currentFile.open(sourcePath, std::ios::binary);
     if (!currentFile) return false;
     
-    currentSerial = serial;
     currentChunkIndex = 0;
-    chunkMetadata.clear();
+    streamInfo = PiraStreamInfo();
     
     // Read header
     char magic[4];
     currentFile.read(magic, 4);
     if (std::memcmp(magic, "PIRA", 4) != 0) {
         std::cerr << "Error: Invalid magic bytes" << std::endl;
-        closeEncryptedFile();
+        close();
         return false;
     }
     
     char version;
     currentFile.read(&version, 1);
-    if (version != 0x02) {
-        std::cerr << "Error: Unsupported version (expected v2)" << std::endl;
-        closeEncryptedFile();
+    if (version != 0x02 && version != 0x03) {
+        std::cerr << "Error: Unsupported version (expected v2 or v3)" << std::endl;
+        close();
         return false;
     }
     
@@ -125,12 +192,98 @@ bool FileHandler::openEncryptedFile(const std::string& sourcePath, const std::st
     
     totalChunks = numChunksU32;
     storedChunkSize = chunkSizeU32;
+    streamInfo.version = static_cast<uint8_t>(version);
+    dataOffset = PIRA_V2_HEADER_SIZE;
+    
+    if (version == 0x03) {
+        char codec, channels;
+        uint32_t sampleRate, firstChunk;
+        currentFile.read(&codec, 1);
+        currentFile.read(&channels, 1);
+        currentFile.read(reinterpret_cast<char*>(&sampleRate), sizeof(uint32_t));
+        currentFile.read(reinterpret_cast<char*>(&firstChunk), sizeof(uint32_t));
+        
+        if (!currentFile.good() || firstChunk < PIRA_V3_HEADER_SIZE) {
+            std::cerr << "Error: Truncated PIRA v3 header" << std::endl;
+            close();
+            return false;
+        }
+        if (codec != PIRA_CODEC_ENCODED && codec != PIRA_CODEC_PCM_S16) {
+            std::cerr << "Error: Unknown PIRA v3 codec " << (int)(uint8_t)codec << std::endl;
+            close();
+            return false;
+        }
+        // A zero frame size or rate would divide by zero in the player
+        if (codec == PIRA_CODEC_PCM_S16 && (channels == 0 || sampleRate == 0)) {
+            std::cerr << "Error: Invalid PIRA v3 PCM format (" << (int)(uint8_t)channels << "ch @ "
+                      << sampleRate << "Hz)" << std::endl;
+            close();
+            return false;
+        }
+
+        streamInfo.codec = static_cast<uint8_t>(codec);
+        streamInfo.channels = static_cast<uint8_t>(channels);
+        streamInfo.sampleRate = sampleRate;
+        dataOffset = firstChunk;
+    }
+    
+    // Derive the key once per file; PBKDF2 is far too slow to run per chunk
+    currentKey = CryptoEngine::deriveKey(serial);
     
-    std::cout << "[FileHandler] Opened PIRA v2: " << totalChunks << " chunks (Avg Size: " << storedChunkSize << ")" << std::endl;
+    if (version == 0x03) {
+        if (!readSections()) {
+            close();
+            return false;
+        }
+        currentFile.clear();
+        currentFile.seekg(dataOffset, std::ios::beg);
+    }
+    
+    std::cout << "[FileHandler] Opened PIRA v" << (int)version << ": " << totalChunks << " chunks (Avg Size: " << storedChunkSize << ")";
+    if (streamInfo.codec == PIRA_CODEC_PCM_S16) {
+        std::cout << " PCM " << (int)streamInfo.channels << "ch @ " << streamInfo.sampleRate << "Hz";
+    }
+    if (!analysis.empty()) {
+        std::cout << " +analysis " << analysis.size() << " bytes";
+    }
+    std::cout << std::endl;
     return true;
 }
 
-std::vector<unsigned char> FileHandler::decryptNextChunk() {
+// Walks the sections between the v3 header and the first chunk. Unknown
+// tags are skipped; an analysis section that fails to decrypt is dropped,
+// the audio itself is still playable.
+bool PiraReader::readSections() {
+    uint32_t pos = PIRA_V3_HEADER_SIZE;
+    while (pos + 8 <= dataOffset) {
+        char sectionTag[4];
+        uint32_t size = 0;
+        currentFile.seekg(pos, std::ios::beg);
+        currentFile.read(sectionTag, 4);
+        currentFile.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+        if (!currentFile.good() || size > dataOffset - pos - 8) {
+            std::cerr << "Error: Corrupt PIRA v3 section table" << std::endl;
+            return false;
+        }
+        
+        if (std::memcmp(sectionTag, PIRA_SECTION_ANALYSIS, 4) == 0 && size > 28) {
+            std::vector<unsigned char> iv(12), tag(16), encrypted(size - 28);
+            currentFile.read(reinterpret_cast<char*>(iv.data()), iv.size());
+            currentFile.read(reinterpret_cast<char*>(tag.data()), tag.size());
+            currentFile.read(reinterpret_cast<char*>(encrypted.data()), encrypted.size());
+            if (currentFile.good()) {
+                analysis = CryptoEngine::decrypt(encrypted, currentKey, iv, tag);
+            }
+            if (analysis.empty()) {
+                std::cerr << "[FileHandler] Analysis section unreadable, ignoring it" << std::endl;
+            }
+        }
+        pos += 8 + size;
+    }
+    return true;
+}
+
+std::vector<unsigned char> PiraReader::decryptNextChunk() {
     if (!currentFile.is_open() || currentChunkIndex >= totalChunks) {
         return {};
     }
@@ -149,7 +302,7 @@ std::vector<unsigned char> FileHandler::decryptNextChunk() {
     
     // Read encrypted chunk data
     // For chunked GCM, encrypted size = plaintext size (GCM doesn't add padding)
-    size_t chunkSize = (currentChunkIndex < totalChunks - 1) ? CHUNK_SIZE_BYTES : CHUNK_SIZE_BYTES;
+    size_t chunkSize = storedChunkSize;
     std::vector<unsigned char> encryptedChunk(chunkSize);
     
     currentFile.read(reinterpret_cast<char*>(encryptedChunk.data()), chunkSize);
@@ -164,38 +317,31 @@ std::vector<unsigned char> FileHandler::decryptNextChunk() {
     encryptedChunk.resize(bytesRead);
     
     // Decrypt
-    std::vector<unsigned char> key = CryptoEngine::deriveKey(currentSerial);
-    std::vector<unsigned char> decrypted = CryptoEngine::decrypt(encryptedChunk, key, iv, tag);
+    std::vector<unsigned char> decrypted = CryptoEngine::decrypt(encryptedChunk, currentKey, iv, tag);
     
     currentChunkIndex++;
     return decrypted;
 }
 
-void FileHandler::closeEncryptedFile() {
+void PiraReader::close() {
     if (currentFile.is_open()) {
         currentFile.close();
     }
-    currentSerial.clear();
+    currentKey.clear();
     totalChunks = 0;
     currentChunkIndex = 0;
-    chunkMetadata.clear();
+    dataOffset = 0;
+    streamInfo = PiraStreamInfo();
+    analysis.clear();
 }
 
-size_t FileHandler::getTotalChunks() {
-    return totalChunks;
-}
-
-size_t FileHandler::getCurrentChunk() {
-    return currentChunkIndex;
-}
-
-void FileHandler::seekToChunk(size_t chunkIndex) {
+void PiraReader::seekToChunk(size_t chunkIndex) {
     if (!currentFile.is_open()) return;
     
     if (chunkIndex >= totalChunks) chunkIndex = totalChunks - 1; // Clamp
     
-    // Header size (4 Magic + 1 Ver + 4 NumChunks + 4 ChunkSize) = 13
-    const size_t headerSize = 13;
+    // Header size: 13 for v2, taken from the v3 header otherwise
+    const size_t headerSize = dataOffset;
     const size_t metadataSize = 12 + 16; // IV + Tag
     
     // Encryption logic (encryptFile) writes fixed size chunks (except maybe last)
@@ -218,22 +364,52 @@ void FileHandler::seekToChunk(size_t chunkIndex) {
     }
 }
 
+// Process-wide reader used by the static streaming API
+bool FileHandler::openEncryptedFile(const std::string& sourcePath, const std::string& serial) {
+    return defaultReader.open(sourcePath, serial);
+}
+
+std::vector<unsigned char> FileHandler::decryptNextChunk() {
+    return defaultReader.decryptNextChunk();
+}
+
+void FileHandler::closeEncryptedFile() {
+    defaultReader.close();
+}
+
+size_t FileHandler::getTotalChunks() {
+    return defaultReader.getTotalChunks();
+}
+
+size_t FileHandler::getCurrentChunk() {
+    return defaultReader.getCurrentChunk();
+}
+
+PiraStreamInfo FileHandler::getStreamInfo() {
+    return defaultReader.getStreamInfo();
+}
+
+void FileHandler::seekToChunk(size_t chunkIndex) {
+    defaultReader.seekToChunk(chunkIndex);
+}
+
 // Compatibility: Decrypt entire file to memory
 std::vector<unsigned char> FileHandler::decryptToMemory(const std::string& sourcePath, const std::string& serial) {
-    if (!openEncryptedFile(sourcePath, serial)) {
+    PiraReader reader;
+    if (!reader.open(sourcePath, serial)) {
         return {};
     }
     
     std::vector<unsigned char> fullData;
     
-    while (currentChunkIndex < totalChunks) {
-        std::vector<unsigned char> chunk = decryptNextChunk();
+    while (reader.getCurrentChunk() < reader.getTotalChunks()) {
+        std::vector<unsigned char> chunk = reader.decryptNextChunk();
         if (chunk.empty()) break;
         
         fullData.insert(fullData.end(), chunk.begin(), chunk.end());
     }
     
-    closeEncryptedFile();
+    reader.close();
     
     std::cout << "[FileHandler] Decrypted " << fullData.size() << " bytes total" << std::endl;
     return fullData;
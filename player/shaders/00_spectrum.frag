@@ -1,10 +1,5 @@
 
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_pitch;
-uniform float u_pos;
-uniform float u_duration;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 void main() {
     vec2 uv = v_uv;
@@ -1,6 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 float rand(float n){return fract(sin(n) * 43758.5453123);}
 
@@ -1,6 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 float hash(vec2 p) { return fract(1e4 * sin(17.0 * p.x + p.y * 0.1) * (0.1 + abs(sin(p.y * 13.0 + p.x)))); }
 
@@ -1,6 +1,7 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
+#pragma feedback
+
+#define OCTAVES TIER(2, 2, 3, 4)
 
 // --- Simplex NoiseUtils ---
 vec3 permute(vec3 x) { return mod(((x*34.0)+1.0)*x, 289.0); }
@@ -37,8 +38,8 @@ float fbm(vec2 p) {
     float persistence = 0.5;
     float scale = 1.0;
     
-    // 3 Octaves for smoothness
-    for(int i=0; i<3; i++) {
+    // 3 Octaves for smoothness (high tier)
+    for(int i=0; i<OCTAVES; i++) {
         total += snoise(p * scale) * persistence;
         scale *= 2.0;
         persistence *= 0.5;
@@ -46,6 +47,11 @@ float fbm(vec2 p) {
     return total;
 }
 
+// Fraction of the dye replaced per second; the rest is last frame's, carried along the flow
+#define DYE_RATE 1.5
+// Flow speed in screen widths per second per unit of warp
+#define FLOW 0.08
+
 void main() {
     vec2 uv = v_uv * 2.0 - 1.0;
     
@@ -54,46 +60,40 @@ void main() {
     float t = u_time * 0.15;
     
     // Audio Integration: 
-    // We average the lowest frequencies to get a very stable "Bass Presence" value
+    // Bass energy from the analyzer gives a very stable "Bass Presence" value
     // This value will only affect the brightness/color shift, NOT the geometry, to prevent twitching.
-    float bass = 0.0;
-    for(float i=0.0; i<0.1; i+=0.01) {
-        bass += texture2D(u_spectrum, vec2(i, 0.5)).r;
-    }
-    bass /= 10.0;
+    float bass = u_features[1].x;
     // Smoothstep to ignore low noise floor
     float energy = smoothstep(0.1, 0.6, bass); 
     
-    // Domain Warping Logic for Liquid feel
+    // One warp layer is the flow field; the deeper layers the procedural version
+    // needed come from advecting the previous frame along it
     vec2 p = uv;
-    
-    // Layer 1
     vec2 q = vec2(0.0);
     q.x = fbm(p + vec2(0.0, 0.0) + t);
     q.y = fbm(p + vec2(5.2, 1.3) - t);
     
-    // Layer 2
-    vec2 r = vec2(0.0);
-    r.x = fbm(p + 4.0*q + vec2(t, t));
-    r.y = fbm(p + 4.0*q + vec2(0.0, t));
-    
-    // Final
-    float f = fbm(p + 4.0*r);
+    // Fresh dye: one octave through the warp instead of two more layers of fbm
+    float f = 0.5 * snoise(p + 4.0*q);
     
-    // Coloring
     // Deep organic colors: Dark Teal -> Blue -> Soft White
-    vec3 col = mix(vec3(0.0, 0.1, 0.2), vec3(0.0, 0.3, 0.4), clamp(f*f*4.0, 0.0, 1.0));
+    vec3 dye = mix(vec3(0.0, 0.1, 0.2), vec3(0.0, 0.3, 0.4), clamp(f*f*4.0, 0.0, 1.0));
     
-    // Mix in warmer tones based on 'r' (the warped coordinate)
-    col = mix(col, vec3(0.3, 0.05, 0.1), clamp(length(q), 0.0, 1.0));
+    // Warmer tones where the flow is strong
+    dye = mix(dye, vec3(0.3, 0.05, 0.1), clamp(length(q), 0.0, 1.0));
     
     // Highlights modulated by audio ENERGY
-    // When music is loud, the liquid glows brighter, but doesn't jerk around.
+    // When music is loud, the liquid glows brighter, but doesn't jerk around
+    // (the dye rate smooths it further).
     vec3 glowColor = vec3(0.2, 0.8, 1.0);
-    col = mix(col, glowColor, clamp(length(r.x), 0.0, 1.0) * energy);
+    dye = mix(dye, glowColor, clamp(abs(q.y) * 2.0, 0.0, 1.0) * energy);
     
     // Soft Vignette
-    col *= 1.2 - dot(uv, uv);
+    dye *= 1.2 - dot(uv, uv);
+    
+    // Last frame, upstream of this pixel; alpha 0 means there is none yet
+    vec4 prev = texture2D(u_prevFrame, v_uv - q * FLOW * u_timeDelta);
+    float fresh = prev.a < 0.5 ? 1.0 : 1.0 - exp(-DYE_RATE * u_timeDelta);
     
-    gl_FragColor = vec4(col, 1.0);
+    gl_FragColor = vec4(mix(prev.rgb, dye, fresh), 1.0);
 }
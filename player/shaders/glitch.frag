@@ -1,6 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 float rand(vec2 n) { 
 	return fract(sin(dot(n, vec2(12.9898, 4.1414))) * 43758.5453);
@@ -9,7 +7,7 @@ float rand(vec2 n) {
 void main() {
     vec2 uv = v_uv;
     
-    float high = texture2D(u_spectrum, vec2(0.8, 0.5)).r; // High freq
+    float high = max(u_features[1].w, u_features[0].z); // Treble, spikes on onsets
     
     // Blocky distortion
     float blockSize = 10.0 + high * 50.0;
@@ -1,6 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 void main() {
     vec2 uv = v_uv;
@@ -9,9 +7,10 @@ void main() {
     float x = uv.x;
     float t = u_time * 2.0;
     
-    // Beat pulse from bass
-    float bass = texture2D(u_spectrum, vec2(0.05, 0.5)).r;
-    float beat = smoothstep(0.4, 0.6, bass); // Trigger
+    // Beat pulse: onsets, plus a decaying kick on the tracked beat
+    float onset = u_features[0].z;
+    float beatPulse = (1.0 - u_features[2].y) * (1.0 - u_features[2].y) * u_features[2].w;
+    float beat = max(smoothstep(0.3, 0.7, onset), beatPulse);
     
     // Base line
     float y = 0.5;
@@ -1,6 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 vec3 palette(float t) {
     vec3 a = vec3(0.5, 0.5, 0.5);
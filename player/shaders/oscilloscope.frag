@@ -1,8 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_duration;
-uniform float u_pos;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 // CRT Distortion
 vec2 warp(vec2 uv) {
@@ -42,33 +38,21 @@ void main() {
     float cY = 1.0 - smoothstep(0.0, 0.005, abs(uv.y - 0.5));
     gridColor += vec3(0.0, 0.6, 0.0) * (cX + cY) * 0.2;
 
-    // 3. Trace (Spectrum Line)
-    // Map frequency (X) to Height (Y)
-    float val = texture2D(u_spectrum, vec2(uv.x, 0.5)).r;
+    // 3. Traces: both channels of the time-domain waveform
+    float left = texture2D(u_waveform, vec2(uv.x, 0.25)).r * 2.0 - 1.0;
+    float right = texture2D(u_waveform, vec2(uv.x, 0.75)).r * 2.0 - 1.0;
     
-    // Scale amplitude
-    val = val * 0.8; 
-    
-    // Center it vertically? Or assume bottom up? Oscilloscopes usually center AC signals.
-    // FFT produces 0..1 magnitude. Let's make it look like a symmetric wave or just positive.
-    // A nice effect for FFT is mirroring it so it looks like a pulse in the center.
-    // Let's try mirroring X first to make it look central.
-    
-    float symX = abs(uv.x - 0.5) * 2.0;
-    float symVal = texture2D(u_spectrum, vec2(symX, 0.5)).r;
-    
-    // Create a "noisy" line
-    float lineY = 0.5 + symVal * 0.4 * sin(uv.x * 100.0 + u_time * 10.0); // Faking symmetry modulation
-    // Actually, just raw FFT looks cleaner for "Spectrum Analyzer Mode"
-    // Let's stick to a raw FFT line trace for clarity but green and glowing.
-    
-    float dist = abs(uv.y - (0.1 + val * 0.8)); // Offset slightly up
+    float distL = abs(uv.y - (0.5 + left * 0.4));
+    float distR = abs(uv.y - (0.5 + right * 0.4));
     
     // Glow calculation
-    float intensity = 0.004 / (dist + 0.001);
+    float glowL = 0.004 / (distL + 0.001);
+    float glowR = 0.004 / (distR + 0.001);
     
-    // Beam color (Phosphor Green)
-    vec3 beamColor = vec3(0.2, 1.0, 0.4) * intensity;
+    // Phosphor green for the left channel; the right drifts to cyan as the image gets wider
+    float width = u_features[3].z;
+    vec3 beamColor = vec3(0.2, 1.0, 0.4) * glowL + mix(vec3(0.2, 1.0, 0.4), vec3(0.2, 0.7, 1.0), width * 2.0) * glowR;
+    beamColor *= 0.6;
     
     // Add jitter/noise
     beamColor *= (0.9 + 0.1 * rand(uv * u_time));
@@ -1,9 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_pitch;
-uniform float u_pos;
-uniform float u_duration;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 vec3 palette(float t) {
     vec3 a = vec3(0.5, 0.5, 0.5);
@@ -31,8 +26,7 @@ void main() {
         d = pow(0.01 / d, 1.2);
         finalColor += col * d;
     }
-    float bass = texture2D(u_spectrum, vec2(0.05, 0.5)).r;
-    finalColor *= (0.8 + bass * 0.5);
+    finalColor *= (0.8 + u_features[1].x * 0.5);
     
     // Progress bar at bottom
     if (v_uv.y < 0.02) {
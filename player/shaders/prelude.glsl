@@ -0,0 +1,39 @@
+// Shared by every visual: #include "prelude.glsl" first thing in a .frag.
+// The player defines QUALITY (0 low, 1 medium, 2 high, 3 ultra) before it,
+// see ShaderPreprocessor. Unused uniforms cost nothing, the compiler drops them.
+
+varying vec2 v_uv;                  // 0..1 across the screen, y up
+
+uniform float u_time;               // Seconds since the visuals started
+uniform float u_timeDelta;          // Seconds since the previous frame (at most 0.25)
+uniform float u_pitch;              // Dominant frequency in Hz
+uniform float u_pos;                // Playback position, seconds
+uniform float u_duration;           // Track length, seconds (1.0 when unknown)
+
+// see AudioFeatures::packUniforms
+// [0] rms, peak, onset, flux          [1] bass, lowMid, highMid, treble
+// [2] centroid (0..1 of Nyquist), beatPhase, bpm, beatConfidence
+// [3] correlation, balance, width
+uniform vec4 u_features[4];
+
+uniform sampler2D u_spectrum;       // Mix spectrum, bands across x
+uniform sampler2D u_spectrumStereo; // Rows: left (y 0.25), right (y 0.75)
+uniform sampler2D u_waveform;       // Rows: left (y 0.25), right (y 0.75); 0.5 = silence
+uniform sampler2D u_spectrogram;    // Ring of past spectra, rows wrap (see u_spectrogramHead)
+uniform float u_spectrogramHead;    // v of the newest row
+
+// Only with '#pragma feedback' in the shader: what it drew last frame, sampled
+// at v_uv (RGBA8, linear, alpha kept). Transparent black after a switch.
+uniform sampler2D u_prevFrame;
+
+// Compile-time constant per quality tier, e.g. loop counts:
+//   for (int i = 0; i < TIER(2, 3, 3, 5); i++)
+#if QUALITY <= 0
+#define TIER(low, medium, high, ultra) (low)
+#elif QUALITY == 1
+#define TIER(low, medium, high, ultra) (medium)
+#elif QUALITY == 2
+#define TIER(low, medium, high, ultra) (high)
+#else
+#define TIER(low, medium, high, ultra) (ultra)
+#endif
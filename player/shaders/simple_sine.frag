@@ -1,7 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_pitch;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 void main() {
     vec2 uv = v_uv;
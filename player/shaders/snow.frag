@@ -1,6 +1,6 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
+
+#define FLAKES TIER(12.0, 20.0, 30.0, 48.0)
 
 float hash(float n) { return fract(sin(n)*43758.5453); }
 
@@ -14,7 +14,7 @@ void main() {
     
     vec3 col = vec3(0.05, 0.05, 0.1); // Night sky
     
-    for(float i=0.0; i<30.0; i++) {
+    for(float i=0.0; i<FLAKES; i++) {
         // Random pos
         float x = hash(i);
         float y = hash(i * 1.23);
@@ -0,0 +1,30 @@
+#include "prelude.glsl"
+
+// Heat palette: black, purple, red, orange, white
+vec3 heat(float v) {
+    vec3 c = mix(vec3(0.0), vec3(0.35, 0.0, 0.5), smoothstep(0.0, 0.25, v));
+    c = mix(c, vec3(0.9, 0.1, 0.1), smoothstep(0.25, 0.5, v));
+    c = mix(c, vec3(1.0, 0.6, 0.0), smoothstep(0.5, 0.75, v));
+    return mix(c, vec3(1.0, 1.0, 0.9), smoothstep(0.75, 1.0, v));
+}
+
+void main() {
+    vec2 uv = v_uv;
+    
+    // Waterfall: frequency across, newest row at the top scrolling down
+    float age = 1.0 - uv.y;
+    float level = texture2D(u_spectrogram, vec2(uv.x, u_spectrogramHead - age)).r;
+    
+    vec3 color = heat(level);
+    
+    // The newest rows flash a little on onsets
+    float onset = u_features[0].z;
+    color += vec3(0.15, 0.1, 0.2) * onset * smoothstep(0.1, 0.0, age);
+    
+    // Progress bar
+    if (uv.y < 0.01 && uv.x < (u_pos / u_duration)) {
+        color = vec3(0.8);
+    }
+    
+    gl_FragColor = vec4(color, 1.0);
+}
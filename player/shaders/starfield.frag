@@ -1,6 +1,6 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
+
+#define LAYERS TIER(2.0, 3.0, 3.0, 4.0)
 
 // Simple hash for randomness
 float hash12(vec2 p) {
@@ -13,16 +13,16 @@ void main() {
     vec2 uv = v_uv * 2.0 - 1.0;
     
     // Audio energy for speed
-    float bass = texture2D(u_spectrum, vec2(0.05, 0.5)).r;
-    float m = texture2D(u_spectrum, vec2(0.5, 0.5)).r;
+    float bass = u_features[1].x;
+    float m = u_features[1].z;
     float speed = 0.5 + bass * 2.0;
     
     vec3 color = vec3(0.0);
     
     // Multiple layers of stars
-    for(float i=0.0; i<3.0; i++) {
+    for(float i=0.0; i<LAYERS; i++) {
         // Projection
-        float z = fract(i/3.0 - u_time * 0.1 * speed);
+        float z = fract(i/LAYERS - u_time * 0.1 * speed);
         float fade = smoothstep(0.0, 0.1, z) * smoothstep(1.0, 0.9, z);
         
         vec2 st = uv * (1.0 + z * 4.0); // Simple perspective
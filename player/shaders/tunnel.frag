@@ -1,7 +1,4 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_pitch; // Hz
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 void main() {
     vec2 uv = v_uv * 2.0 - 1.0;
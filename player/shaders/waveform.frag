@@ -1,17 +1,12 @@
-varying vec2 v_uv;
-uniform float u_time;
-uniform float u_pitch;
-uniform float u_pos;
-uniform float u_duration;
-uniform sampler2D u_spectrum;
+#include "prelude.glsl"
 
 void main() {
     vec2 uv = v_uv;
-    // Mirror
-    if (uv.x > 0.5) uv.x = 1.0 - uv.x;
-    uv.x *= 2.0;
 
-    float val = texture2D(u_spectrum, vec2(uv.x, 0.5)).r;
+    // Filled waveform: left channel above the centre line, right below
+    float left = abs(texture2D(u_waveform, vec2(uv.x, 0.25)).r * 2.0 - 1.0);
+    float right = abs(texture2D(u_waveform, vec2(uv.x, 0.75)).r * 2.0 - 1.0);
+    float val = (uv.y > 0.5) ? left : right;
     float dist = abs(uv.y - 0.5) * 2.0;
     
     vec3 color = vec3(0.0);
@@ -0,0 +1,300 @@
+#include "AudioDsp.hpp"
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const float DSP_PI = 3.14159265358979f;
+
+// --- Kernels ---------------------------------------------------------------
+
+static void s16ToFloat(const int16_t* in, float* out, size_t n) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+#endif
+    for (; i < n; ++i) out[i] = in[i] * scale;
+}
+
+#if defined(__ARM_NEON) && !defined(__SSE2__)
+// Round to nearest like cvtps and lrintf; plain vcvtq truncates toward zero
+static inline int32x4_t roundToS32(float32x4_t v) {
+#if defined(__aarch64__)
+    return vcvtnq_s32_f32(v);
+#else
+    // ARMv7 has no rounding convert: +-0.5 with the sign of v, then truncate (ties away from zero)
+    uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000u));
+    float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    return vcvtq_s32_f32(vaddq_f32(v, half));
+#endif
+}
+#endif
+
+// Same 32768 as s16ToFloat, so a pass that changes nothing gives back the input;
+// +1.0 saturates to 32767
+static void floatToS16(const float* in, int16_t* out, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= n; i += 8) {
+        // cvtps rounds to nearest, packs saturates to int16
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), vscale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        // The convert saturates to int32, vqmovn saturates to int16
+        int32x4_t lo = roundToS32(vmulq_n_f32(vld1q_f32(in + i), 32768.0f));
+        int32x4_t hi = roundToS32(vmulq_n_f32(vld1q_f32(in + i + 4), 32768.0f));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+    for (; i < n; ++i) {
+        float v = in[i] * 32768.0f;
+        if (v > 32767.0f) v = 32767.0f;
+        if (v < -32768.0f) v = -32768.0f;
+        out[i] = (int16_t)lrintf(v);
+    }
+}
+
+static void scale(float* buf, size_t n, float gain) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 vgain = _mm_set1_ps(gain);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), vgain));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(buf + i, vmulq_n_f32(vld1q_f32(buf + i), gain));
+    }
+#endif
+    for (; i < n; ++i) buf[i] *= gain;
+}
+
+// --- AudioDsp --------------------------------------------------------------
+
+AudioDsp::AudioDsp()
+    : m_dirty(false), m_format(ma_format_unknown), m_channels(0), m_sampleRate(0),
+      m_gain(1.0f), m_targetGain(1.0f), m_gainStep(0.0f), m_rampRemaining(0),
+      m_lastBlockNs(0), m_maxBlockNs(0) {
+    std::memset(m_state, 0, sizeof(m_state));
+}
+
+void AudioDsp::configure(ma_format format, ma_uint32 channels, ma_uint32 sampleRate) {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+
+    m_format = format;
+    m_channels = (channels > MAX_CHANNELS) ? MAX_CHANNELS : channels;
+    m_sampleRate = sampleRate;
+    m_scratch.assign(MAX_BLOCK_FRAMES * m_channels, 0.0f);
+    std::memset(m_state, 0, sizeof(m_state));
+
+    // New track starts at the target gain, no ramp from the previous one
+    updateCoefficients(m_pending);
+    m_active = m_pending;
+    m_dirty = false;
+    m_targetGain = m_active.volume * std::pow(10.0f, m_active.replayGainDb / 20.0f);
+    m_gain = m_targetGain;
+    m_rampRemaining = 0;
+    m_maxBlockNs = 0;
+}
+
+void AudioDsp::setVolume(float volume) {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    m_pending.volume = volume;
+    m_dirty = true;
+}
+
+void AudioDsp::setReplayGain(float db) {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    m_pending.replayGainDb = (db < -24.0f) ? -24.0f : (db > 12.0f) ? 12.0f : db;
+    m_dirty = true;
+}
+
+float AudioDsp::getReplayGain() const {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    return m_pending.replayGainDb;
+}
+
+bool AudioDsp::setBand(int index, float freqHz, float gainDb, float q) {
+    if (index < 0 || index >= MAX_BANDS || freqHz <= 0.0f || q <= 0.0f) return false;
+
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    m_pending.bands[index].freq = freqHz;
+    m_pending.bands[index].gainDb = gainDb;
+    m_pending.bands[index].q = q;
+    if (index >= m_pending.bandCount) {
+        // Bands in between stay flat
+        for (int i = m_pending.bandCount; i < index; ++i) m_pending.bands[i] = Band();
+        m_pending.bandCount = index + 1;
+    }
+    updateCoefficients(m_pending);
+    m_dirty = true;
+    return true;
+}
+
+void AudioDsp::clearEq() {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    m_pending.bandCount = 0;
+    m_dirty = true;
+}
+
+void AudioDsp::updateCoefficients(Params& p) const {
+    // RBJ cookbook peaking filter
+    float fs = (m_sampleRate > 0) ? (float)m_sampleRate : 44100.0f;
+    for (int i = 0; i < p.bandCount; ++i) {
+        const Band& band = p.bands[i];
+        float freq = (band.freq < fs * 0.49f) ? band.freq : fs * 0.49f;
+        float A = std::pow(10.0f, band.gainDb / 40.0f);
+        float w0 = 2.0f * DSP_PI * freq / fs;
+        float alpha = std::sin(w0) / (2.0f * band.q);
+        float cosw = std::cos(w0);
+        float a0 = 1.0f + alpha / A;
+
+        Biquad& c = p.coeffs[i];
+        c.b0 = (1.0f + alpha * A) / a0;
+        c.b1 = (-2.0f * cosw) / a0;
+        c.b2 = (1.0f - alpha * A) / a0;
+        c.a1 = (-2.0f * cosw) / a0;
+        c.a2 = (1.0f - alpha / A) / a0;
+    }
+}
+
+void AudioDsp::applyPending() {
+    // Never wait on the control thread; pick the change up next block instead
+    if (!m_dirty || !m_paramMutex.try_lock()) return;
+
+    int oldBands = m_active.bandCount;
+    m_active = m_pending;
+    m_dirty = false;
+    m_paramMutex.unlock();
+
+    // Newly enabled bands start from silence history
+    for (int i = oldBands; i < m_active.bandCount; ++i) {
+        std::memset(m_state[i], 0, sizeof(m_state[i]));
+    }
+
+    float target = m_active.volume * std::pow(10.0f, m_active.replayGainDb / 20.0f);
+    if (target != m_targetGain) {
+        m_targetGain = target;
+        m_rampRemaining = (ma_uint32)(m_sampleRate * RAMP_MS / 1000.0f);
+        if (m_rampRemaining == 0) m_rampRemaining = 1;
+        m_gainStep = (m_targetGain - m_gain) / (float)m_rampRemaining;
+    }
+}
+
+void AudioDsp::processFloat(float* samples, ma_uint32 frameCount) {
+    const ma_uint32 channels = m_channels;
+
+    // EQ: cascade of transposed direct form II biquads per channel
+    for (int b = 0; b < m_active.bandCount; ++b) {
+        const Biquad& c = m_active.coeffs[b];
+        for (ma_uint32 ch = 0; ch < channels; ++ch) {
+            float z1 = m_state[b][ch][0];
+            float z2 = m_state[b][ch][1];
+            float* s = samples + ch;
+            for (ma_uint32 i = 0; i < frameCount; ++i, s += channels) {
+                float x = *s;
+                float y = c.b0 * x + z1;
+                z1 = c.b1 * x - c.a1 * y + z2;
+                z2 = c.b2 * x - c.a2 * y;
+                *s = y;
+            }
+            // Flush denormals so an idle filter never slows down
+            m_state[b][ch][0] = (std::fabs(z1) < 1e-20f) ? 0.0f : z1;
+            m_state[b][ch][1] = (std::fabs(z2) < 1e-20f) ? 0.0f : z2;
+        }
+    }
+
+    // Gain: per-frame ramp while moving, vector multiply once settled
+    ma_uint32 i = 0;
+    float* s = samples;
+    for (; i < frameCount && m_rampRemaining > 0; ++i, --m_rampRemaining) {
+        m_gain += m_gainStep;
+        for (ma_uint32 ch = 0; ch < channels; ++ch) *s++ *= m_gain;
+    }
+    if (m_rampRemaining == 0) m_gain = m_targetGain;
+    if (i < frameCount && m_gain != 1.0f) {
+        scale(s, (size_t)(frameCount - i) * channels, m_gain);
+    }
+}
+
+void AudioDsp::process(void* frames, ma_uint32 frameCount) {
+    if (m_channels == 0 || m_channels > MAX_CHANNELS) return;
+
+    applyPending();
+
+    // Bit-exact passthrough when nothing would change the signal
+    if (m_active.bandCount == 0 && m_rampRemaining == 0 && m_gain == 1.0f) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    const ma_uint32 channels = m_channels;
+    ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(m_format, channels);
+    ma_uint8* pos = (ma_uint8*)frames;
+
+    while (frameCount > 0) {
+        ma_uint32 n = (frameCount < MAX_BLOCK_FRAMES) ? frameCount : MAX_BLOCK_FRAMES;
+        size_t samples = (size_t)n * channels;
+
+        if (m_format == ma_format_f32) {
+            processFloat((float*)pos, n);
+        } else if (m_format == ma_format_s16) {
+            s16ToFloat((const int16_t*)pos, m_scratch.data(), samples);
+            processFloat(m_scratch.data(), n);
+            floatToS16(m_scratch.data(), (int16_t*)pos, samples);
+        } else {
+            ma_pcm_convert(m_scratch.data(), ma_format_f32, pos, m_format, samples, ma_dither_mode_none);
+            processFloat(m_scratch.data(), n);
+            ma_pcm_convert(pos, m_format, m_scratch.data(), ma_format_f32, samples, ma_dither_mode_none);
+        }
+
+        pos += n * bytesPerFrame;
+        frameCount -= n;
+    }
+
+    uint32_t ns = (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    m_lastBlockNs = ns;
+    if (ns > m_maxBlockNs) m_maxBlockNs = ns;
+}
+
+std::string AudioDsp::describe() const {
+    std::lock_guard<std::mutex> lock(m_paramMutex);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "volume " << (int)(m_pending.volume * 100) << "%, replaygain " << m_pending.replayGainDb << "dB, eq ";
+    if (m_pending.bandCount == 0) {
+        ss << "off";
+    } else {
+        for (int i = 0; i < m_pending.bandCount; ++i) {
+            const Band& b = m_pending.bands[i];
+            ss << (i ? " " : "") << "[" << i << ": " << (int)b.freq << "Hz " << b.gainDb << "dB Q" << b.q << "]";
+        }
+    }
+    ss << ", block " << m_lastBlockNs / 1000.0f << "us (max " << m_maxBlockNs / 1000.0f << "us)";
+    return ss.str();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../include/miniaudio.h"
+
+/**
+ * AudioDsp - Output stage between the decoder and the device
+ *
+ * Chain: N-band peaking EQ -> smoothed gain (volume x ReplayGain).
+ * Parameters are set from the control thread and picked up by the audio
+ * thread at the next block without blocking it. Conversion and gain use
+ * SSE2/NEON kernels when available; cost is bounded by MAX_BANDS and
+ * MAX_BLOCK_FRAMES.
+ */
+class AudioDsp {
+public:
+    static const int MAX_BANDS = 8;
+    static const int MAX_CHANNELS = 8;
+    static const ma_uint32 MAX_BLOCK_FRAMES = 1024;
+    static constexpr float RAMP_MS = 20.0f;
+
+    AudioDsp();
+
+    // Called before the device starts (allocates, not real-time safe)
+    void configure(ma_format format, ma_uint32 channels, ma_uint32 sampleRate);
+
+    // Control thread
+    void setVolume(float volume);              // Linear 0.0 - 1.0, ramped
+    void setReplayGain(float db);              // Per-track gain in dB, ramped
+    bool setBand(int index, float freqHz, float gainDb, float q);
+    void clearEq();
+    float getReplayGain() const;
+    std::string describe() const;
+
+    // Audio thread: processes interleaved frames in place
+    void process(void* frames, ma_uint32 frameCount);
+
+private:
+    struct Band {
+        float freq = 1000.0f;
+        float gainDb = 0.0f;
+        float q = 1.0f;
+    };
+    struct Biquad {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    };
+    struct Params {
+        float volume = 1.0f;
+        float replayGainDb = 0.0f;
+        int bandCount = 0;
+        Band bands[MAX_BANDS];
+        Biquad coeffs[MAX_BANDS];
+    };
+
+    void updateCoefficients(Params& p) const;
+    void applyPending();
+    void processFloat(float* samples, ma_uint32 frameCount);
+
+    // Control side
+    mutable std::mutex m_paramMutex;
+    Params m_pending;
+    std::atomic<bool> m_dirty;
+
+    // Audio side (only touched by process() once configured)
+    Params m_active;
+    ma_format m_format;
+    ma_uint32 m_channels;
+    ma_uint32 m_sampleRate;
+    float m_gain;
+    float m_targetGain;
+    float m_gainStep;
+    ma_uint32 m_rampRemaining;
+    float m_state[MAX_BANDS][MAX_CHANNELS][2];
+    std::vector<float> m_scratch;
+
+    std::atomic<uint32_t> m_lastBlockNs;
+    std::atomic<uint32_t> m_maxBlockNs;
+};
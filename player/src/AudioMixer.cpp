@@ -0,0 +1,301 @@
+#include "AudioMixer.hpp"
+#include "Realtime.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+static const ma_uint32 MIX_BLOCK_FRAMES = 4096;
+
+AudioMixer::AudioMixer(Mode mode) : m_mode(mode), m_mix(new Mix()) {}
+
+AudioMixer::~AudioMixer() {
+    closeDevice();
+    if (m_contextInitialized) {
+        ma_context_uninit(&m_context);
+    }
+    delete m_mix.load();
+}
+
+std::shared_ptr<AudioMixer> AudioMixer::shared() {
+    static std::shared_ptr<AudioMixer> mixer = std::make_shared<AudioMixer>(Mode::Device);
+    return mixer;
+}
+
+const char* AudioMixer::detectDeviceClass() {
+    // Pi Zero / single core: cheapest resampler; small multi-core ARM: medium
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores <= 1) return "low";
+#if defined(__arm__) || defined(__aarch64__)
+    if (cores <= 4) return "mid";
+#endif
+    return "high";
+}
+
+bool AudioMixer::negotiate() {
+    if (m_negotiated) return true;
+
+    m_deviceClass = detectDeviceClass();
+    m_lpfOrder = (m_deviceClass == "low") ? 0 : (m_deviceClass == "mid") ? 4 : MA_MAX_FILTER_ORDER;
+    m_format.format = ma_format_s16;
+
+    if (m_mode == Mode::Offline) {
+        m_negotiated = true;
+        return true;
+    }
+
+    if (!m_contextInitialized) {
+        ma_backend nullBackend = ma_backend_null;
+        ma_result result = (m_mode == Mode::NullDevice)
+            ? ma_context_init(&nullBackend, 1, NULL, &m_context)
+            : ma_context_init(NULL, 0, NULL, &m_context);
+        if (result != MA_SUCCESS) {
+            return false;
+        }
+        m_contextInitialized = true;
+    }
+
+    ma_device_info info;
+    if (ma_context_get_device_info(&m_context, ma_device_type_playback, NULL, &info) == MA_SUCCESS) {
+        // Prefer s16, then f32, then whatever the hardware lists first
+        static const ma_format preference[] = { ma_format_s16, ma_format_f32 };
+        ma_format chosen = ma_format_unknown;
+        for (ma_format wanted : preference) {
+            for (ma_uint32 i = 0; i < info.nativeDataFormatCount && chosen == ma_format_unknown; ++i) {
+                ma_format f = info.nativeDataFormats[i].format;
+                if (f == wanted || f == ma_format_unknown) chosen = wanted;
+            }
+            if (chosen != ma_format_unknown) break;
+        }
+        if (chosen == ma_format_unknown && info.nativeDataFormatCount > 0) {
+            chosen = info.nativeDataFormats[0].format;
+        }
+        if (chosen != ma_format_unknown) m_format.format = chosen;
+
+        // Native rates for that format; a 0 rate means the device takes anything
+        bool anyRate = false;
+        for (ma_uint32 i = 0; i < info.nativeDataFormatCount; ++i) {
+            const auto& nf = info.nativeDataFormats[i];
+            if (nf.format != m_format.format && nf.format != ma_format_unknown) continue;
+            if (nf.sampleRate == 0) anyRate = true;
+            else m_nativeRates.push_back(nf.sampleRate);
+        }
+        if (anyRate) m_nativeRates.clear();
+
+        std::cout << "[AudioMixer] Device: " << info.name << " native " << ma_get_format_name(m_format.format);
+        for (ma_uint32 rate : m_nativeRates) std::cout << " " << rate;
+        if (m_nativeRates.empty()) std::cout << " (any rate)";
+        std::cout << std::endl;
+    } else {
+        std::cerr << "[AudioMixer] Could not query device, assuming s16 at any rate" << std::endl;
+    }
+
+    if (m_format.format != ma_format_s16 && m_format.format != ma_format_f32) {
+        std::cerr << "[AudioMixer] WARNING: " << ma_get_format_name(m_format.format)
+                  << " output, only the first source will be heard" << std::endl;
+    }
+
+    m_negotiated = true;
+    return true;
+}
+
+ma_format AudioMixer::getPreferredFormat() {
+    std::lock_guard<std::mutex> control(m_controlMutex);
+    negotiate();
+    return m_format.format;
+}
+
+bool AudioMixer::openDevice(ma_uint32 channels, ma_uint32 sampleRate) {
+    // Sources are already in the device format; the device only resamples when
+    // the hardware cannot run at the stream's rate, using the per-class quality.
+    ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
+    deviceConfig.playback.format   = m_format.format;
+    deviceConfig.playback.channels = channels;
+    deviceConfig.sampleRate        = sampleRate;
+    deviceConfig.resampling.algorithm = ma_resample_algorithm_linear;
+    deviceConfig.resampling.linear.lpfOrder = m_lpfOrder;
+    deviceConfig.dataCallback      = dataCallback;
+    deviceConfig.pUserData         = this;
+
+    if (ma_device_init(&m_context, &deviceConfig, &m_device) != MA_SUCCESS) {
+        std::cerr << "[AudioMixer] Failed to open playback device" << std::endl;
+        return false;
+    }
+    m_deviceInitialized = true;
+
+    // Everything queued in the device's periods (converted to our rate) is still to be heard
+    const ma_device& dev = m_device;
+    ma_uint64 queued = (ma_uint64)dev.playback.internalPeriodSizeInFrames * dev.playback.internalPeriods;
+    if (dev.playback.internalSampleRate > 0) queued = queued * sampleRate / dev.playback.internalSampleRate;
+    queued += ma_data_converter_get_output_latency(&dev.playback.converter);
+    m_latencyFrames = (ma_uint32)queued;
+
+    std::stringstream info;
+    info << ma_get_format_name(m_format.format) << " " << sampleRate << "Hz " << channels << "ch";
+    info << " -> device " << ma_get_format_name(dev.playback.internalFormat) << " "
+         << dev.playback.internalSampleRate << "Hz " << dev.playback.internalChannels << "ch";
+    bool converts = dev.playback.internalFormat != m_format.format || dev.playback.internalChannels != channels;
+    bool resamples = dev.playback.internalSampleRate != sampleRate;
+    info << " (class " << m_deviceClass << ", ";
+    if (resamples) info << "resample lpf" << m_lpfOrder;
+    else if (converts) info << "format conversion";
+    else info << "passthrough";
+    info << ", latency " << (m_latencyFrames * 1000 / sampleRate) << " ms)";
+    m_outputInfo = info.str();
+    std::cout << "[AudioMixer] Output: " << m_outputInfo << std::endl;
+    return true;
+}
+
+void AudioMixer::closeDevice() {
+    if (m_deviceInitialized) {
+        ma_device_uninit(&m_device);
+        m_deviceInitialized = false;
+        m_deviceRunning = false;
+        m_latencyFrames = 0;
+    }
+}
+
+bool AudioMixer::attach(Source* source, ma_uint32 channels, ma_uint32 sampleRate, Format& out) {
+    std::lock_guard<std::mutex> control(m_controlMutex);
+    if (!negotiate()) return false;
+
+    bool alone = m_sources.empty();
+
+    // Nobody else is listening: follow the new stream so it plays without conversion
+    if (alone && (m_format.channels != channels || m_format.sampleRate != sampleRate || 
+                  (m_mode != Mode::Offline && !m_deviceInitialized))) {
+        if (m_mode != Mode::Offline) {
+            closeDevice();
+            if (!openDevice(channels, sampleRate)) return false;
+        } else {
+            std::stringstream info;
+            info << ma_get_format_name(m_format.format) << " " << sampleRate << "Hz " << channels << "ch (offline)";
+            m_outputInfo = info.str();
+        }
+        // A render still on the old Mix has no sources, it does not touch the scratch
+        m_format.channels = channels;
+        m_format.sampleRate = sampleRate;
+        m_mixScratch.assign(MIX_BLOCK_FRAMES * ma_get_bytes_per_frame(m_format.format, channels), 0);
+    }
+
+    m_sources.push_back(source);
+    publish();
+
+    if (m_mode != Mode::Offline && !m_deviceRunning) {
+        if (ma_device_start(&m_device) != MA_SUCCESS) {
+            std::cerr << "[AudioMixer] Failed to start playback device" << std::endl;
+            m_sources.erase(std::remove(m_sources.begin(), m_sources.end(), source), m_sources.end());
+            publish();
+            return false;
+        }
+        m_deviceRunning = true;
+    }
+
+    out = m_format;
+    return true;
+}
+
+void AudioMixer::detach(Source* source) {
+    std::lock_guard<std::mutex> control(m_controlMutex);
+    // Once this returns the device thread is no longer inside 'source'
+    m_sources.erase(std::remove(m_sources.begin(), m_sources.end(), source), m_sources.end());
+    publish();
+    bool empty = m_sources.empty();
+
+    // Idle device costs CPU on the Pi; restart on the next attach
+    if (empty && m_deviceRunning) {
+        ma_device_stop(&m_device);
+        m_deviceRunning = false;
+    }
+}
+
+void AudioMixer::dataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount) {
+    AudioMixer* mixer = (AudioMixer*)pDevice->pUserData;
+    if (mixer == NULL) return;
+
+    // The device thread is created by miniaudio; claim it on the first period
+    static thread_local bool s_realtimeApplied = false;
+    if (!s_realtimeApplied) {
+        Realtime::applyToCurrentThread(Realtime::Role::Audio);
+        s_realtimeApplied = true;
+    }
+    mixer->render(pOutput, frameCount);
+}
+
+void AudioMixer::publish() {
+    const Mix* previous = m_mix.exchange(new Mix{ m_sources, m_format });
+    // A render that started before the exchange may still hold 'previous'; any later one
+    // loads the new Mix. Renders take a device period at most, sleeping beats spinning here.
+    uint64_t seq = m_renderSeq.load();
+    while ((seq & 1) && m_renderSeq.load() == seq) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    delete previous;
+}
+
+ma_uint32 AudioMixer::render(void* pOutput, ma_uint32 frameCount) {
+    // Odd while rendering, see publish(); both are sequentially consistent
+    m_renderSeq.fetch_add(1);
+    const Mix& mix = *m_mix.load();
+    const Format& format = mix.format;
+    const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(format.format, format.channels);
+    ma_uint8* out = (ma_uint8*)pOutput;
+
+    if (mix.sources.empty() || bytesPerFrame == 0) {
+        std::memset(out, 0, (size_t)frameCount * bytesPerFrame);
+        m_renderSeq.fetch_add(1);
+        return frameCount;
+    }
+
+    // First source renders in place, no mixing cost for the common single-player case
+    ma_uint32 got = mix.sources[0]->readFrames(out, frameCount);
+    if (got < frameCount) {
+        std::memset(out + (size_t)got * bytesPerFrame, 0, (size_t)(frameCount - got) * bytesPerFrame);
+    }
+
+    bool canMix = (format.format == ma_format_s16 || format.format == ma_format_f32);
+    for (size_t i = 1; canMix && i < mix.sources.size(); ++i) {
+        ma_uint32 done = 0;
+        while (done < frameCount) {
+            ma_uint32 n = std::min(frameCount - done, MIX_BLOCK_FRAMES);
+            ma_uint32 read = mix.sources[i]->readFrames(m_mixScratch.data(), n);
+            if (read == 0) break;
+            mixInto(format, out + (size_t)done * bytesPerFrame, m_mixScratch.data(), read);
+            done += read;
+            if (read < n) break;
+        }
+    }
+    m_renderSeq.fetch_add(1);
+    return frameCount;
+}
+
+void AudioMixer::mixInto(const Format& format, void* pOutput, const void* pInput, ma_uint32 frameCount) {
+    size_t samples = (size_t)frameCount * format.channels;
+    if (format.format == ma_format_s16) {
+        int16_t* out = (int16_t*)pOutput;
+        const int16_t* in = (const int16_t*)pInput;
+        for (size_t i = 0; i < samples; ++i) {
+            int32_t v = (int32_t)out[i] + in[i];
+            out[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+        }
+    } else {
+        float* out = (float*)pOutput;
+        const float* in = (const float*)pInput;
+        for (size_t i = 0; i < samples; ++i) out[i] += in[i];
+    }
+}
+
+AudioMixer::Format AudioMixer::getFormat() const {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    return m_format;
+}
+
+std::string AudioMixer::getOutputInfo() const {
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    std::stringstream ss;
+    ss << m_outputInfo;
+    if (!m_outputInfo.empty()) ss << ", " << m_sources.size() << " source(s)";
+    return ss.str();
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../include/miniaudio.h"
+
+/**
+ * AudioMixer - Owns the playback device and sums every attached source
+ *
+ * All AudioPlayer instances share one mixer (the main output plus e.g. a
+ * preview/cue player). The output format is negotiated once with the
+ * device; sources deliver frames already in that format, so conversion
+ * happens in at most one place per source.
+ *
+ * Modes:
+ *   Device      default playback device
+ *   NullDevice  miniaudio null backend, real-time clocked without a sound card
+ *   Offline     no device at all, the caller pulls frames with render()
+ *
+ * render() runs on the real-time device thread and never takes a lock:
+ * attach/detach publish an immutable snapshot of the sources and the
+ * format, and a render sequence counter (odd while rendering) tells them
+ * when the device thread has let go of the previous one.
+ */
+class AudioMixer {
+public:
+    enum class Mode { Device, NullDevice, Offline };
+
+    struct Format {
+        ma_format format = ma_format_s16;
+        ma_uint32 channels = 0;
+        ma_uint32 sampleRate = 0;
+    };
+
+    class Source {
+    public:
+        virtual ~Source() = default;
+        // Called on the device thread; returns frames written (rest is silence)
+        virtual ma_uint32 readFrames(void* pOutput, ma_uint32 frameCount) = 0;
+    };
+
+    explicit AudioMixer(Mode mode = Mode::Device);
+    ~AudioMixer();
+
+    // Process-wide mixer on the default device
+    static std::shared_ptr<AudioMixer> shared();
+
+    // Sample format sources should produce (negotiated on first use)
+    bool negotiate();
+    ma_format getPreferredFormat();
+
+    // Attach a source producing 'channels' at 'sampleRate'. When it is the only
+    // source the device is (re)opened at exactly that rate; otherwise 'out' tells
+    // the source which rate/channels to convert to.
+    bool attach(Source* source, ma_uint32 channels, ma_uint32 sampleRate, Format& out);
+    void detach(Source* source);
+
+    // Offline mode: pull mixed frames (also used by the device callback)
+    ma_uint32 render(void* pOutput, ma_uint32 frameCount);
+
+    // Offline sources may block for data instead of rendering an underrun
+    bool isOffline() const { return m_mode == Mode::Offline; }
+
+    Format getFormat() const;
+    ma_uint32 getLpfOrder() const { return m_lpfOrder; }
+    // Frames (at the mixer rate) between render() and the speaker: device buffer plus resampler
+    ma_uint32 getLatencyFrames() const { return m_latencyFrames; }
+    std::string getOutputInfo() const;
+
+private:
+    static void dataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount);
+    static const char* detectDeviceClass();
+    bool openDevice(ma_uint32 channels, ma_uint32 sampleRate);
+    void closeDevice();
+    // What render() works from; replaced as a whole, never modified once published
+    struct Mix {
+        std::vector<Source*> sources;
+        Format format;
+    };
+    // Control thread: publishes m_sources and m_format, returns once no render uses the old Mix
+    void publish();
+    static void mixInto(const Format& format, void* pOutput, const void* pInput, ma_uint32 frameCount);
+
+    Mode m_mode;
+    ma_context m_context;
+    bool m_contextInitialized = false;
+    ma_device m_device;
+    bool m_deviceInitialized = false;
+    bool m_deviceRunning = false;
+    bool m_negotiated = false;
+
+    Format m_format;
+    std::vector<ma_uint32> m_nativeRates; // Informational, empty = any
+    ma_uint32 m_lpfOrder = 0;
+    std::atomic<ma_uint32> m_latencyFrames{0};
+    std::string m_deviceClass;
+    std::string m_outputInfo;
+
+    mutable std::mutex m_controlMutex;   // Serialises attach/detach/open and the getters; never taken by render()
+    std::vector<Source*> m_sources;      // Control side, under m_controlMutex
+    std::atomic<const Mix*> m_mix;
+    std::atomic<uint64_t> m_renderSeq{0};
+    std::vector<unsigned char> m_mixScratch;  // Device thread; only resized while no source is attached
+};
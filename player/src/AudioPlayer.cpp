@@ -1,112 +1,303 @@
-#define MINIAUDIO_IMPLEMENTATION
 #include "../include/miniaudio.h"
 
 #include "AbbyCrypt.hpp"
 #include "AudioPlayer.hpp"
 #include "FileHandler.hpp"
+#include "Realtime.hpp"
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <time.h>
 
-// Global context
-struct PlayerContext {
-    ma_decoder decoder;
-    ma_device device;
-    std::vector<unsigned char> audioData;
-    bool initialized = false;
-    FrequencyAnalyzer* analyzer = nullptr;
-};
+static uint64_t nowNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
 
-PlayerContext g_ctx; 
+// Largest single read a decoder makes (dr_mp3 refills up to MA_DR_MP3_DATA_CHUNK_SIZE)
+static const size_t DECODER_READ_BYTES = 64 * 1024;
 
-// miniaudio data callback
-void data_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
+// Feeds output-format frames to the analyzer, which works on float samples
+static void analyzeOutput(FrequencyAnalyzer* analyzer, const void* pFrames, ma_format format, ma_uint32 sampleCount)
 {
-    struct PlayerContext* ctx = (struct PlayerContext*)pDevice->pUserData;
-    if (ctx == NULL) return;
+    // Nobody is looking at the spectrum: skip even the conversion
+    if (!analyzer->isActive()) return;
+    
+    if (format == ma_format_f32) {
+        analyzer->pushSamples((const float*)pFrames, sampleCount);
+        return;
+    }
+    if (format == ma_format_s16) {
+        analyzer->pushSamples((const int16_t*)pFrames, sampleCount);
+        return;
+    }
+    
+    // Other integer formats: convert in small stack blocks
+    float block[256];
+    const ma_uint8* src = (const ma_uint8*)pFrames;
+    ma_uint32 bytesPerSample = ma_get_bytes_per_sample(format);
+    while (sampleCount > 0) {
+        ma_uint32 n = (sampleCount < 256) ? sampleCount : 256;
+        ma_pcm_convert(block, ma_format_f32, src, format, n, ma_dither_mode_none);
+        analyzer->pushSamples(block, n);
+        src += n * bytesPerSample;
+        sampleCount -= n;
+    }
+}
 
-    ma_uint64 framesRead = 0;
-    ma_decoder_read_pcm_frames(&ctx->decoder, pOutput, frameCount, &framesRead);
+// Mixer source callback (device thread): renders this player's frames in the mixer format
+ma_uint32 AudioPlayer::readFrames(void* pOutput, ma_uint32 frameCount)
+{
+    if (!m_attached || m_isPaused) return 0;
+    
+    // A seek on the control thread owns the decoder; play silence until it is done
+    std::unique_lock<std::mutex> lock(m_decoderMutex, std::try_to_lock);
+    if (!lock.owns_lock()) return 0;
+    
+    uint64_t t0 = nowNs();
+    uint64_t sourceBefore = m_statSourceNs;
+    ma_uint32 framesRead = m_hasConverter ? readConverted(pOutput, frameCount)
+                                          : readSourceFrames(pOutput, frameCount);
+    double endPosition = (double)m_pcmCursor / m_sourceRate;
+    lock.unlock();
+    uint64_t t1 = nowNs();
+    if (m_hasConverter) {
+        uint64_t sourceNs = m_statSourceNs - sourceBefore;
+        m_statConvertNs += (t1 - t0 > sourceNs) ? (t1 - t0 - sourceNs) : 0;
+    }
     
+    ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(m_outFormat.format, m_outFormat.channels);
     if (framesRead < frameCount) {
         // std::cerr << "[Callback] Underrun? Req: " << frameCount << " Read: " << framesRead << std::endl;
+        std::memset((uint8_t*)pOutput + framesRead * bytesPerFrame, 0, (frameCount - framesRead) * bytesPerFrame);
+        
+        // Never waits for the decrypt thread: a busy buffer is an underrun, the next block asks again
+        bool endOfTrack = false;
+        if (m_decryptDone) {
+            std::unique_lock<std::mutex> bufferLock(m_bufferMutex, std::try_to_lock);
+            endOfTrack = bufferLock.owns_lock() && m_rollingBuffer.empty();
+        }
+        if (endOfTrack) {
+            m_finished = true;
+        } else {
+            m_statUnderruns++;
+            m_statUnderrunFrames += frameCount - framesRead;
+        }
+    }
+    if (framesRead > 0) {
+        if (m_firstAudioNs == 0) m_firstAudioNs = t1 - m_playStartNs;
+        if (m_seekStartNs != 0) {
+            m_seekLatencyNs = t1 - m_seekStartNs;
+            m_seekStartNs = 0;
+        }
     }
+    m_statFrames += framesRead;
+    m_statCallbacks++;
     
-    if (ctx->analyzer) {
-        ctx->analyzer->pushSamples((float*)pOutput, frameCount * ctx->decoder.outputChannels);
+    analyzeOutput(m_analyzer.get(), pOutput, m_outFormat.format, frameCount * m_outFormat.channels);
+    // Starts the analyzer's output clock for this block (visuals follow what is heard)
+    m_analyzer->setPlaybackPosition(endPosition);
+    uint64_t t2 = nowNs();
+    
+    // Volume ramp, ReplayGain and EQ (analyzer sees the pre-volume signal)
+    m_dsp.process(pOutput, frameCount);
+    uint64_t t3 = nowNs();
+    
+    m_statAnalyzeNs += t2 - t1;
+    m_statDspNs += t3 - t2;
+    return frameCount;
+}
+
+// Frames in the source's own format: replayed from history after a backward
+// seek, otherwise from the decoder or straight from the PCM stream
+ma_uint32 AudioPlayer::readSourceFrames(void* pOutput, ma_uint32 frameCount)
+{
+    uint64_t t0 = nowNs();
+    ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels);
+    
+    ma_uint32 framesRead = m_history.read(m_pcmCursor, pOutput, frameCount);
+    m_pcmCursor += framesRead;
+    
+    // The decoder/stream is parked at m_history.end(); continue from there once caught up
+    if (framesRead < frameCount) {
+        void* pLive = (ma_uint8*)pOutput + (size_t)framesRead * bytesPerFrame;
+        ma_uint32 liveFrames = 0;
+        if (m_rawPcm) {
+            // Raw PCM: copy straight from the rolling buffer, never block the device thread
+            // (an offline mixer has no deadline, so it waits for decryption instead)
+            size_t bytesRead = readBuffered(pLive, (frameCount - framesRead) * bytesPerFrame, m_mixer->isOffline() ? 500 : 0);
+            liveFrames = (ma_uint32)(bytesRead / bytesPerFrame);
+        } else if (m_mixer->isOffline()) {
+            ma_uint64 decoded = 0;
+            ma_decoder_read_pcm_frames(&m_decoder, pLive, frameCount - framesRead, &decoded);
+            liveFrames = (ma_uint32)decoded;
+        } else {
+            // The decoder reads through ds_read: hold the buffer for it without waiting, and only
+            // once a whole decoder read is there, since dr_mp3 takes a short read as end of stream
+            std::unique_lock<std::mutex> bufferLock(m_bufferMutex, std::try_to_lock);
+            if (bufferLock.owns_lock() && (m_decryptDone || hasBufferedLocked(DECODER_READ_BYTES))) {
+                ma_uint64 decoded = 0;
+                m_decoderHoldsBuffer = true;
+                ma_decoder_read_pcm_frames(&m_decoder, pLive, frameCount - framesRead, &decoded);
+                m_decoderHoldsBuffer = false;
+                liveFrames = (ma_uint32)decoded;
+            }
+        }
+        m_history.append(pLive, liveFrames);
+        m_historyHeld = m_history.end() - m_history.start();
+        m_pcmCursor += liveFrames;
+        framesRead += liveFrames;
     }
-} 
+    m_statSourceNs += nowNs() - t0;
+    return framesRead;
+}
+
+// Only used when the mixer runs at another rate/layout than this stream
+ma_uint32 AudioPlayer::readConverted(void* pOutput, ma_uint32 frameCount)
+{
+    ma_uint32 inBytesPerFrame = ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels);
+    ma_uint32 outBytesPerFrame = ma_get_bytes_per_frame(m_outFormat.format, m_outFormat.channels);
+    ma_uint64 capacity = m_convertScratch.size() / inBytesPerFrame;
+    ma_uint8* out = (ma_uint8*)pOutput;
+    ma_uint32 done = 0;
+    
+    while (done < frameCount) {
+        ma_uint64 wantIn = 0;
+        ma_data_converter_get_required_input_frame_count(&m_converter, frameCount - done, &wantIn);
+        if (wantIn > capacity) wantIn = capacity;
+        if (wantIn == 0) wantIn = 1;
+        
+        ma_uint64 framesIn = readSourceFrames(m_convertScratch.data(), (ma_uint32)wantIn);
+        ma_uint64 framesOut = frameCount - done;
+        ma_data_converter_process_pcm_frames(&m_converter, m_convertScratch.data(), &framesIn,
+                                             out + (size_t)done * outBytesPerFrame, &framesOut);
+        done += (ma_uint32)framesOut;
+        if (framesIn < wantIn || framesOut == 0) break;
+    }
+    return done;
+}
 
 ma_result AudioPlayer::ds_read(ma_decoder* pDecoder, void* pBufferOut, size_t bytesToRead, size_t* pBytesRead) {
     AudioPlayer* player = (AudioPlayer*)pDecoder->pUserData;
-    size_t bytesRead = 0;
-    uint8_t* outPtr = (uint8_t*)pBufferOut;
     
-    // std::cout << "[ds_read] [" << player << "] Req: " << bytesToRead << std::endl;
-
     // Early exit if stop requested
     if (player->m_stopSignal) {
         if (pBytesRead) *pBytesRead = 0;
         return MA_AT_END;
     }
+    
+    size_t bytesRead = 0;
+    if (player->m_decoderHoldsBuffer) {
+        uint64_t t0 = nowNs();
+        bytesRead = player->takeBuffered(pBufferOut, bytesToRead);
+        player->m_statReadNs += nowNs() - t0;
+    } else {
+        bytesRead = player->readBuffered(pBufferOut, bytesToRead, 500);
+    }
+    
+    // std::cout << "[ds_read] Returning " << bytesRead << " bytes" << std::endl;
+    if (pBytesRead) *pBytesRead = bytesRead;
+    if (player->m_stopSignal && bytesRead == 0) return MA_AT_END;
+    return MA_SUCCESS; 
+}
+
+size_t AudioPlayer::readBuffered(void* pBufferOut, size_t bytesToRead, int waitMs) {
+    uint64_t t0 = nowNs();
+    size_t bytesRead = 0;
+    uint8_t* outPtr = (uint8_t*)pBufferOut;
+    
+    std::unique_lock<std::mutex> lock(m_bufferMutex, std::defer_lock);
+    if (waitMs > 0) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        // Decrypt thread or a seek is in there: an underrun for the caller, not a stall
+        m_statReadNs += nowNs() - t0;
+        return 0;
+    }
 
     while (bytesToRead > 0) {
-        std::unique_lock<std::mutex> lock(player->m_bufferMutex);
-        
-        // Wait for data (timeout for seek/init)
-        bool gotData = player->m_bufferCV.wait_for(lock, std::chrono::milliseconds(500), [player]() {
-            return !player->m_rollingBuffer.empty() || player->m_stopSignal || player->m_seekRequested;
-        });
+        // Wait for data (timeout for seek/init); nothing more will come after the last chunk
+        if (waitMs > 0) {
+            m_bufferCV.wait_for(lock, std::chrono::milliseconds(waitMs), [this]() {
+                return !m_rollingBuffer.empty() || m_stopSignal || m_seekRequested || m_decryptDone;
+            });
+        }
         
         // Exit on stop
-        if (player->m_stopSignal) {
-            if (pBytesRead) *pBytesRead = bytesRead;
-            return bytesRead > 0 ? MA_SUCCESS : MA_AT_END;
-        }
+        if (m_stopSignal) break;
         
         // Exit on seek (caller should retry after seek completes)
-        if (player->m_seekRequested) break;
+        if (m_seekRequested) break;
         
         // If buffer empty after timeout, this is an underrun or EOF
-        if (player->m_rollingBuffer.empty()) {
-            // std::cerr << "[ds_read] Buffer Empty! Underrun." << std::endl;
-            break;
-        }
-        
+        size_t copied = takeBuffered(outPtr, bytesToRead);
+        if (copied == 0) break;
+        outPtr += copied;
+        bytesRead += copied;
+        bytesToRead -= copied;
+    }
+    
+    m_statReadNs += nowNs() - t0;
+    return bytesRead;
+}
+
+size_t AudioPlayer::takeBuffered(void* pBufferOut, size_t bytesToRead) {
+    size_t bytesRead = 0;
+    uint8_t* outPtr = (uint8_t*)pBufferOut;
+    
+    while (bytesToRead > 0 && !m_rollingBuffer.empty()) {
         // Read from front chunk
-        AudioChunk& chunk = player->m_rollingBuffer.front();
-        size_t available = chunk.data.size() - player->m_readOffsetInFrontChunk;
+        AudioChunk& chunk = m_rollingBuffer.front();
+        size_t available = chunk.data.size() - m_readOffsetInFrontChunk;
         size_t toCopy = (bytesToRead < available) ? bytesToRead : available;
         
         if (toCopy > 0) {
-            std::memcpy(outPtr, chunk.data.data() + player->m_readOffsetInFrontChunk, toCopy);
+            std::memcpy(outPtr, chunk.data.data() + m_readOffsetInFrontChunk, toCopy);
             
             outPtr += toCopy;
             bytesRead += toCopy;
             bytesToRead -= toCopy;
-            player->m_readOffsetInFrontChunk += toCopy;
+            m_readOffsetInFrontChunk += toCopy;
         }
         
         // Remove chunk if fully consumed
-        if (player->m_readOffsetInFrontChunk >= chunk.data.size()) {
-            // std::cout << "[ds_read] Consumed chunk " << chunk.chunkIndex << std::endl;
-            player->m_readOffsetInFrontChunk = 0;
-            player->m_rollingBuffer.pop_front();
-            player->m_bufferCV.notify_all(); // Notify producer that space is available
+        if (m_readOffsetInFrontChunk >= chunk.data.size()) {
+            m_readOffsetInFrontChunk = 0;
+            m_rollingBuffer.pop_front();
+            m_bufferCV.notify_all(); // Notify producer that space is available
         }
     }
-    
-    // std::cout << "[ds_read] Returning " << bytesRead << " bytes" << std::endl;
-    if (pBytesRead) *pBytesRead = bytesRead;
-    return MA_SUCCESS; 
+    return bytesRead;
+}
+
+bool AudioPlayer::hasBufferedLocked(size_t bytes) const {
+    size_t held = 0;
+    size_t skip = m_readOffsetInFrontChunk;
+    for (const AudioChunk& chunk : m_rollingBuffer) {
+        held += chunk.data.size() - std::min(skip, chunk.data.size());
+        skip = 0;
+        if (held >= bytes) return true;
+    }
+    return false;
 }
 
 ma_result AudioPlayer::ds_seek(ma_decoder* pDecoder, ma_int64 byteOffset, ma_seek_origin origin) {
     AudioPlayer* player = (AudioPlayer*)pDecoder->pUserData;
     
-    // Constant for PIRA v2
-    const size_t chunkSize = 176400; 
+    // Constant for PIRA v2/v3
+    const size_t chunkSize = CHUNK_SIZE_BYTES; 
     
     // Total estimated size
     size_t totalSize = player->m_totalChunks * chunkSize;
@@ -134,32 +325,38 @@ ma_result AudioPlayer::ds_seek(ma_decoder* pDecoder, ma_int64 byteOffset, ma_see
     // Clamp
     if (targetPos > totalSize) targetPos = totalSize;
     
+    player->seekToStreamPos(targetPos);
+    return MA_SUCCESS;
+}
+
+void AudioPlayer::seekToStreamPos(size_t targetPos) {
+    const size_t chunkSize = CHUNK_SIZE_BYTES;
+    
     size_t chunkIndex = targetPos / chunkSize;
     size_t offsetInChunk = targetPos % chunkSize;
     
-    std::cout << "[ds_seek] Request: " << byteOffset << " Origin: " << (int)origin 
-              << " -> Target: " << targetPos << " (Chunk " << chunkIndex << "+" << offsetInChunk << ")" << std::endl;
+    std::cout << "[ds_seek] Target: " << targetPos << " (Chunk " << chunkIndex << "+" << offsetInChunk << ")" << std::endl;
     
-    std::unique_lock<std::mutex> lock(player->m_bufferMutex);
+    std::unique_lock<std::mutex> lock(m_bufferMutex);
     
     // OPTIMIZATION: If seeking within the currently buffered range, just adjust read offset
     // This prevents clearing the buffer during ma_decoder_init's probing
-    if (!player->m_rollingBuffer.empty()) {
-        size_t frontChunk = player->m_rollingBuffer.front().chunkIndex;
-        size_t backChunk = player->m_rollingBuffer.back().chunkIndex;
+    if (!m_rollingBuffer.empty()) {
+        size_t frontChunk = m_rollingBuffer.front().chunkIndex;
+        size_t backChunk = m_rollingBuffer.back().chunkIndex;
         
         if (chunkIndex >= frontChunk && chunkIndex <= backChunk) {
             // Target is within buffered range - find the chunk and adjust
-            for (auto it = player->m_rollingBuffer.begin(); it != player->m_rollingBuffer.end(); ++it) {
+            for (auto it = m_rollingBuffer.begin(); it != m_rollingBuffer.end(); ++it) {
                 if (it->chunkIndex == chunkIndex) {
                     // Calculate bytes to pop from front
-                    size_t chunksToPop = std::distance(player->m_rollingBuffer.begin(), it);
+                    size_t chunksToPop = std::distance(m_rollingBuffer.begin(), it);
                     for (size_t i = 0; i < chunksToPop; ++i) {
-                        player->m_rollingBuffer.pop_front();
+                        m_rollingBuffer.pop_front();
                     }
-                    player->m_readOffsetInFrontChunk = offsetInChunk;
+                    m_readOffsetInFrontChunk = offsetInChunk;
                     std::cout << "[ds_seek] Optimized - staying in buffer (popped " << chunksToPop << " chunks)" << std::endl;
-                    return MA_SUCCESS;
+                    return;
                 }
             }
         }
@@ -167,38 +364,43 @@ ma_result AudioPlayer::ds_seek(ma_decoder* pDecoder, ma_int64 byteOffset, ma_see
     
     // Full seek: clear buffer and request refill from decryptionLoop
     std::cout << "[ds_seek] Full seek to chunk " << chunkIndex << std::endl;
-    player->m_seekRequested = true;
-    player->m_seekTargetChunk = chunkIndex;
-    player->m_seekOffsetInChunk = offsetInChunk;
+    // Seeking to the end (decoder probing the length) has no chunk to wait for
+    bool atEnd = chunkIndex >= m_totalChunks;
+    m_seekRequested = true;
+    m_decryptDone = false;
+    m_seekTargetChunk = chunkIndex;
+    m_seekOffsetInChunk = offsetInChunk;
         
-    player->m_rollingBuffer.clear();
-    player->m_readOffsetInFrontChunk = offsetInChunk; 
+    m_rollingBuffer.clear();
+    m_readOffsetInFrontChunk = offsetInChunk; 
         
-    player->m_bufferCV.notify_all(); // Wake decryption thread
+    m_bufferCV.notify_all(); // Wake decryption thread
     
     // Wait for decryptionLoop to fill at least one chunk after seek
     // This is CRITICAL for ma_decoder_init which needs immediate data after seek
-    player->m_bufferCV.wait_for(lock, std::chrono::seconds(3), [player, chunkIndex]() {
-        if (player->m_stopSignal) return true;
-        if (player->m_rollingBuffer.empty()) return false;
+    m_bufferCV.wait_for(lock, std::chrono::seconds(3), [this, chunkIndex, atEnd]() {
+        if (m_stopSignal || atEnd) return true;
+        if (m_rollingBuffer.empty()) return false;
         // Verify we have the target chunk
-        return player->m_rollingBuffer.front().chunkIndex == chunkIndex;
+        return m_rollingBuffer.front().chunkIndex == chunkIndex;
     });
     
-    if (player->m_rollingBuffer.empty()) {
+    if (atEnd) {
+        std::cout << "[ds_seek] Seek to end of stream" << std::endl;
+    } else if (m_rollingBuffer.empty()) {
         std::cerr << "[ds_seek] WARNING: Timeout waiting for buffer refill after seek!" << std::endl;
     } else {
-        std::cout << "[ds_seek] Buffer refilled with chunk " << player->m_rollingBuffer.front().chunkIndex << std::endl;
+        std::cout << "[ds_seek] Buffer refilled with chunk " << m_rollingBuffer.front().chunkIndex << std::endl;
     }
     
-    player->m_seekRequested = false; // Clear seek flag after refill
-    
-    return MA_SUCCESS;
+    m_seekRequested = false; // Clear seek flag after refill
 } 
 
-AudioPlayer::AudioPlayer() 
+AudioPlayer::AudioPlayer(std::shared_ptr<AudioMixer> mixer) 
     : m_isPlaying(false), m_isPaused(false), m_stopSignal(false), m_volume(1.0f),
-      m_totalChunks(0), m_currentChunkIndex(0) {
+      m_totalChunks(0), m_currentChunkIndex(0),
+      m_mixer(mixer ? mixer : AudioMixer::shared()), m_attached(false), m_pcmCursor(0),
+      m_decryptDone(false) {
     m_analyzer = std::make_shared<FrequencyAnalyzer>();
 }
 
@@ -206,23 +408,58 @@ AudioPlayer::~AudioPlayer() {
     stop();
 }
 
+void AudioPlayer::abortPlayback() {
+    // Threads first: the decryption worker still reads from the stream
+    m_stopSignal = true;
+    m_bufferCV.notify_all();
+    if (m_decryptionWorker.joinable()) m_decryptionWorker.join();
+    if (m_hasDecoder) {
+        ma_decoder_uninit(&m_decoder);
+        m_hasDecoder = false;
+    }
+    m_stream.close();
+}
+
 void AudioPlayer::play(const std::string& filepath) {
     stop();
     m_lastError = "";
 
     std::cerr << "[AudioPlayer] [" << this << "] Opening encrypted file: " << filepath << std::endl;
+    resetPipelineStats();
+    m_playStartNs = nowNs();
     
     m_currentFilePath = filepath;
     std::string serial = Abby::AbbyCrypt::getHardwareSerial();
     
     // Open for streaming
-    if (!Abby::AbbyCrypt::openEncryptedFile(filepath, serial)) {
+    if (!m_stream.open(filepath, serial)) {
         std::cerr << "[AudioPlayer] Failed to open encrypted file" << std::endl;
         return;
     }
     
-    m_totalChunks = Abby::AbbyCrypt::getTotalChunks();
+    m_totalChunks = m_stream.getTotalChunks();
     m_currentChunkIndex = 0;
+    
+    // Precomputed analysis (encrypt_util --analysis) replaces the live FFT
+    std::shared_ptr<TrackAnalysis> analysis;
+    if (!m_stream.getAnalysis().empty()) {
+        analysis = TrackAnalysis::parse(m_stream.getAnalysis());
+        if (analysis) {
+            std::cout << "[AudioPlayer] Precomputed analysis: " << analysis->describe() << std::endl;
+        } else {
+            std::cerr << "[AudioPlayer] Unsupported analysis section, analysing live" << std::endl;
+        }
+    }
+    m_analyzer->setTrackAnalysis(analysis);
+    m_trackGainKnown = analysis && analysis->loudnessDb() > -70.0f;
+    if (m_trackGainKnown) {
+        // Up to the reference, but the loudest peak (8-bit overview, rounded up) stays below full scale
+        uint8_t peak = 0;
+        for (uint8_t p : analysis->waveform()) peak = std::max(peak, p);
+        float headroomDb = -20.0f * std::log10(std::min(1.0f, (peak + 1) / 255.0f));
+        m_trackLoudnessDb = analysis->loudnessDb();
+        m_trackGainDb = std::min(REFERENCE_LOUDNESS_DB - analysis->loudnessDb(), headroomDb);
+    }
     m_readOffsetInFrontChunk = 0;
     
     std::cerr << "[AudioPlayer] Total chunks: " << m_totalChunks << std::endl;
@@ -232,13 +469,13 @@ void AudioPlayer::play(const std::string& filepath) {
         std::lock_guard<std::mutex> lock(m_bufferMutex);
         m_rollingBuffer.clear();
     }
-    g_ctx.audioData.clear(); // Unused in streaming mode
 
     // CRITICAL: Reset state before starting threads
     m_stopSignal = false;
     m_seekRequested = false;
     m_seekTargetChunk = 0;
     m_seekOffsetInChunk = 0;
+    m_decryptDone = false;
 
     // Start decryption thread to pre-buffer
     m_decryptionWorker = std::thread(&AudioPlayer::decryptionLoop, this, filepath);
@@ -251,63 +488,106 @@ void AudioPlayer::play(const std::string& filepath) {
             return !m_rollingBuffer.empty() || m_stopSignal; 
         })) {
              std::cerr << "[AudioPlayer] Timeout waiting for pre-buffer!" << std::endl;
-             FileHandler::closeEncryptedFile();
-             m_stopSignal = true;
-             if(m_decryptionWorker.joinable()) m_decryptionWorker.join();
+             lock.unlock();
+             abortPlayback();
              return;
         }
     }
     
     if (m_stopSignal || m_rollingBuffer.empty()) {
        std::cerr << "[AudioPlayer] Failed to pre-buffer (Empty/Stop)" << std::endl;
+       abortPlayback();
        return;
     }
 
-    // Initialize decoder with CUSTOM CALLBACKS
-    ma_decoder_config decoderConfig = ma_decoder_config_init_default();
-    ma_result result = ma_decoder_init(ds_read, ds_seek, this, &decoderConfig, &g_ctx.decoder);
+    // Decode straight to the sample format the shared output runs in
+    ma_format outputFormat = m_mixer->getPreferredFormat();
 
-    if (result != MA_SUCCESS) {
-        std::cerr << "[AudioPlayer] Failed to initialize decoder: " << result << std::endl;
-        FileHandler::closeEncryptedFile();
-        m_stopSignal = true;
-        if(m_decryptionWorker.joinable()) m_decryptionWorker.join();
-        return;
+    Abby::TrackInfo trackInfo = m_stream.getTrackInfo();
+    m_rawPcm = trackInfo.rawPcm;
+    
+    if (m_rawPcm) {
+        // PIRA v3 PCM: the stream already is device-ready s16, no decoder needed
+        if (trackInfo.channels == 0 || trackInfo.sampleRate == 0) {
+            std::cerr << "[AudioPlayer] Invalid PCM format: " << trackInfo.channels << "ch @ "
+                      << trackInfo.sampleRate << "Hz" << std::endl;
+            abortPlayback();
+            return;
+        }
+        m_sourceFormat = ma_format_s16;
+        m_sourceChannels = trackInfo.channels;
+        m_sourceRate = trackInfo.sampleRate;
+        m_hasDecoder = false;
+        
+        std::cout << "[AudioPlayer] Raw PCM stream, decoder bypassed." << std::endl;
+    } else {
+        // Initialize decoder with CUSTOM CALLBACKS
+        // Decode straight to the negotiated device format at the stream's own rate
+        ma_decoder_config decoderConfig = ma_decoder_config_init(outputFormat, 0, 0);
+        ma_result result = ma_decoder_init(ds_read, ds_seek, this, &decoderConfig, &m_decoder);
+
+        if (result != MA_SUCCESS) {
+            std::cerr << "[AudioPlayer] Failed to initialize decoder: " << result << std::endl;
+            abortPlayback();
+            return;
+        }
+        
+        m_sourceFormat = m_decoder.outputFormat;
+        m_sourceChannels = m_decoder.outputChannels;
+        m_sourceRate = m_decoder.outputSampleRate;
+        m_hasDecoder = true;
+        
+        std::cout << "[AudioPlayer] Decoder Init OK." << std::endl;
     }
     
-    std::cout << "[AudioPlayer] Decoder Init OK." << std::endl;
-    std::cout << "  Format: " << g_ctx.decoder.outputFormat << std::endl;
-    std::cout << "  Channels: " << g_ctx.decoder.outputChannels << std::endl;
-    std::cout << "  SampleRate: " << g_ctx.decoder.outputSampleRate << std::endl;
+    std::cout << "  Format: " << m_sourceFormat << std::endl;
+    std::cout << "  Channels: " << m_sourceChannels << std::endl;
+    std::cout << "  SampleRate: " << m_sourceRate << std::endl;
     
-    g_ctx.analyzer = m_analyzer.get();
-
-    // Initialize device
-    ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
-    deviceConfig.playback.format   = g_ctx.decoder.outputFormat;
-    deviceConfig.playback.channels = g_ctx.decoder.outputChannels;
-    deviceConfig.sampleRate        = g_ctx.decoder.outputSampleRate;
-    deviceConfig.dataCallback      = data_callback;
-    deviceConfig.pUserData         = &g_ctx;
+    // Decoded frames are kept so backward seeks inside the window skip decrypt + decode
+    m_history.configure(ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels),
+                        (ma_uint64)(m_historySeconds * m_sourceRate));
+    m_historyHeld = 0;
+    m_pcmCursor = 0;
 
-    if (ma_device_init(NULL, &deviceConfig, &g_ctx.device) != MA_SUCCESS) {
+    // Join the shared output. readFrames() stays silent until m_attached is set.
+    if (!m_mixer->attach(this, m_sourceChannels, m_sourceRate, m_outFormat)) {
         std::cerr << "[AudioPlayer] Failed to open playback device" << std::endl;
-        ma_decoder_uninit(&g_ctx.decoder);
-        FileHandler::closeEncryptedFile();
+        abortPlayback();
         return;
     }
-
-    if (ma_device_start(&g_ctx.device) != MA_SUCCESS) {
-        std::cerr << "[AudioPlayer] Failed to start playback device" << std::endl;
-        ma_device_uninit(&g_ctx.device);
-        ma_decoder_uninit(&g_ctx.decoder);
-        FileHandler::closeEncryptedFile();
-        return;
+    
+    // Another player already owns the device rate/layout: convert once here
+    m_hasConverter = (m_outFormat.format != m_sourceFormat || m_outFormat.channels != m_sourceChannels ||
+                      m_outFormat.sampleRate != m_sourceRate);
+    if (m_hasConverter) {
+        ma_data_converter_config convConfig = ma_data_converter_config_init(
+            m_sourceFormat, m_outFormat.format, m_sourceChannels, m_outFormat.channels,
+            m_sourceRate, m_outFormat.sampleRate);
+        convConfig.resampling.algorithm = ma_resample_algorithm_linear;
+        convConfig.resampling.linear.lpfOrder = m_mixer->getLpfOrder();
+        if (ma_data_converter_init(&convConfig, NULL, &m_converter) != MA_SUCCESS) {
+            std::cerr << "[AudioPlayer] Failed to create converter" << std::endl;
+            m_mixer->detach(this);
+            m_hasConverter = false;
+            abortPlayback();
+            return;
+        }
+        m_convertScratch.assign(4096 * ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels), 0);
+        std::cout << "[AudioPlayer] Converting to shared output " << m_outFormat.sampleRate << "Hz "
+                  << m_outFormat.channels << "ch" << std::endl;
     }
+    
+    applyReplayGain();
+    m_dsp.setVolume(m_volume);
+    m_dsp.configure(m_outFormat.format, m_outFormat.channels, m_outFormat.sampleRate);
+    m_analyzer->configure((float)m_outFormat.sampleRate, (int)m_outFormat.channels);
+    m_analyzer->setOutputLatency((int)m_mixer->getLatencyFrames());
 
-    g_ctx.initialized = true;
+    m_isPaused = false;
     m_isPlaying = true;
     m_stopSignal = false;
+    m_attached = true;
     
     // Launch playback monitor
     m_playbackWorker = std::thread(&AudioPlayer::playbackLoop, this, filepath);
@@ -322,7 +602,15 @@ void AudioPlayer::stop() {
             std::lock_guard<std::mutex> lock(m_bufferMutex);
             m_bufferCV.notify_all();
         }
-        
+    }
+    
+    // After detach the device thread no longer calls into this player
+    if (m_attached) {
+        m_mixer->detach(this);
+        m_attached = false;
+    }
+    
+    if (m_isPlaying) {
         if (m_playbackWorker.joinable()) {
             m_playbackWorker.join();
         }
@@ -335,14 +623,18 @@ void AudioPlayer::stop() {
         std::cout << "[AudioPlayer] Stopped" << std::endl;
     }
 
-    if (g_ctx.initialized) {
-        ma_device_uninit(&g_ctx.device);
-        ma_decoder_uninit(&g_ctx.decoder);
-        g_ctx.initialized = false;
-        g_ctx.audioData.clear();
+    if (m_hasDecoder) {
+        ma_decoder_uninit(&m_decoder);
+        m_hasDecoder = false;
+    }
+    if (m_hasConverter) {
+        ma_data_converter_uninit(&m_converter, NULL);
+        m_hasConverter = false;
     }
     
-    FileHandler::closeEncryptedFile();
+    m_stream.close();
+    m_analyzer->setTrackAnalysis(nullptr);
+    m_trackGainKnown = false;
     
     {
         std::lock_guard<std::mutex> lock(m_bufferMutex);
@@ -351,34 +643,53 @@ void AudioPlayer::stop() {
 }
 
 void AudioPlayer::pause() {
-    if (m_isPlaying && !m_isPaused && g_ctx.initialized) {
-        ma_device_stop(&g_ctx.device);
+    // The player stays attached and renders silence; other sources keep playing
+    if (m_isPlaying && !m_isPaused && m_attached) {
         m_isPaused = true;
         std::cout << "[AudioPlayer] Paused" << std::endl;
     }
 }
 
 void AudioPlayer::resume() {
-    if (m_isPlaying && m_isPaused && g_ctx.initialized) {
-        ma_device_start(&g_ctx.device);
+    if (m_isPlaying && m_isPaused && m_attached) {
         m_isPaused = false;
         std::cout << "[AudioPlayer] Resumed" << std::endl;
     }
 }
 
 void AudioPlayer::seek(float seconds) {
-    if (!g_ctx.initialized) return;
-    
-    ma_uint64 targetFrame = (ma_uint64)(seconds * g_ctx.decoder.outputSampleRate);
-    ma_decoder_seek_to_pcm_frame(&g_ctx.decoder, targetFrame);
+    if (!m_attached) return;
+    
+    m_seekStartNs = nowNs();
+    std::lock_guard<std::mutex> lock(m_decoderMutex);
+    m_finished = false;
+    ma_uint64 targetFrame = (ma_uint64)(seconds * m_sourceRate);
+    if (m_history.contains(targetFrame)) {
+        // Replay from memory; decryption and the decoder are not touched
+        m_pcmCursor = targetFrame;
+        m_historyHits++;
+    } else {
+        if (m_rawPcm) {
+            // Byte position maps directly onto the chunk layout
+            seekToStreamPos(targetFrame * ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels));
+        } else {
+            ma_decoder_seek_to_pcm_frame(&m_decoder, targetFrame);
+        }
+        m_history.reset(targetFrame);
+        m_historyHeld = 0;
+        m_pcmCursor = targetFrame;
+        m_historyMisses++;
+    }
+    if (m_hasConverter) {
+        ma_data_converter_reset(&m_converter);
+    }
     std::cout << "[AudioPlayer] Seeked to " << seconds << "s" << std::endl;
 }
 
 void AudioPlayer::setVolume(float volume) {
     m_volume = (volume < 0.0f) ? 0.0f : (volume > 1.0f) ? 1.0f : volume;
-    if (g_ctx.initialized) {
-        ma_device_set_master_volume(&g_ctx.device, m_volume);
-    }
+    // Ramped in the DSP stage to avoid clicks (master volume jumps per period)
+    m_dsp.setVolume(m_volume);
     std::cout << "[AudioPlayer] Volume set to " << (int)(m_volume * 100) << "%" << std::endl;
 }
 
@@ -386,20 +697,46 @@ float AudioPlayer::getVolume() const {
     return m_volume;
 }
 
+void AudioPlayer::setReplayGain(float db) {
+    m_replayGainAuto = false;
+    m_replayGainDb = db;
+    applyReplayGain();
+}
+
+void AudioPlayer::setReplayGainAuto() {
+    m_replayGainAuto = true;
+    applyReplayGain();
+}
+
+void AudioPlayer::applyReplayGain() {
+    m_dsp.setReplayGain(!m_replayGainAuto ? (float)m_replayGainDb : m_trackGainKnown ? (float)m_trackGainDb : 0.0f);
+}
+
+std::string AudioPlayer::getReplayGainInfo() const {
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    if (!m_replayGainAuto) {
+        ss << "replaygain fixed " << m_replayGainDb << " dB";
+    } else if (m_trackGainKnown) {
+        ss << "replaygain auto, " << m_dsp.getReplayGain() << " dB for this track (loudness " << m_trackLoudnessDb
+           << " dBFS, reference " << REFERENCE_LOUDNESS_DB << ")";
+    } else {
+        ss << "replaygain auto, 0 dB (no track analysis)";
+    }
+    return ss.str();
+}
+
+std::string AudioPlayer::getOutputInfo() const {
+    return m_mixer->getOutputInfo();
+}
+
 std::string AudioPlayer::getStatus() {
     std::stringstream ss;
-    if (m_isPlaying && g_ctx.initialized) {
-        ma_uint64 cursor;
-        // ma_uint64 total;
-        ma_decoder_get_cursor_in_pcm_frames(&g_ctx.decoder, &cursor);
-        // ma_decoder_get_length_in_pcm_frames(&g_ctx.decoder, &total);
-        
-        // float currentSec = (float)cursor / (float)g_ctx.decoder.outputSampleRate;
-        // float totalSec = (float)total / (float)g_ctx.decoder.outputSampleRate;
-        
-        // Approximate duration
-        float currentSec = (float)cursor / (float)g_ctx.decoder.outputSampleRate;
-        float totalSec = (float)m_totalChunks; // 1 chunk ~= 1 second
+    if (m_isPlaying && m_attached) {
+        PlaybackState state = getPlaybackState();
+        float currentSec = state.currentTime;
+        float totalSec = state.totalTime;
 
         if (m_isPaused) {
             ss << "PAUSED [" << (int)currentSec << "s / " << (int)totalSec << "s]";
@@ -418,22 +755,97 @@ std::string AudioPlayer::getStatus() {
 
 AudioPlayer::PlaybackState AudioPlayer::getPlaybackState() {
     PlaybackState state;
-    state.isPlaying = m_isPlaying && g_ctx.initialized && !m_isPaused;
+    state.isPlaying = m_isPlaying && m_attached && !m_isPaused;
     state.isPaused = m_isPaused;
     state.volume = m_volume;
     
-    if (m_isPlaying && g_ctx.initialized) {
-        ma_uint64 cursor; 
-        // ma_uint64 total;
-        ma_decoder_get_cursor_in_pcm_frames(&g_ctx.decoder, &cursor);
-        // ma_decoder_get_length_in_pcm_frames(&g_ctx.decoder, &total);
-        
-        state.currentTime = (float)cursor / (float)g_ctx.decoder.outputSampleRate;
-        state.totalTime = (float)m_totalChunks; // total / (float)g_ctx.decoder.outputSampleRate;
+    if (m_isPlaying && m_attached) {
+        state.currentTime = (float)getCursorFrames() / (float)m_sourceRate;
+        if (m_rawPcm) {
+            // Chunks hold a fixed number of PCM bytes, so the duration is exact (to a chunk)
+            ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(m_sourceFormat, m_sourceChannels);
+            state.totalTime = (float)(m_totalChunks * CHUNK_SIZE_BYTES / bytesPerFrame) / (float)m_sourceRate;
+        } else {
+            state.totalTime = (float)m_totalChunks; // 1 chunk ~= 1 second
+        }
     }
     return state;
 }
 
+double AudioPlayer::getLengthSeconds() {
+    if (!m_isPlaying || !m_attached) return 0.0;
+    if (m_rawPcm) return getPlaybackState().totalTime;
+    
+    std::lock_guard<std::mutex> lock(m_decoderMutex);
+    ma_uint64 frames = 0;
+    if (!m_hasDecoder || ma_decoder_get_length_in_pcm_frames(&m_decoder, &frames) != MA_SUCCESS || frames == 0) {
+        return getPlaybackState().totalTime;
+    }
+    return (double)frames / m_sourceRate;
+}
+
+AudioPlayer::PipelineStats AudioPlayer::getPipelineStats() const {
+    PipelineStats stats;
+    stats.decryptNs = m_statDecryptNs;
+    stats.decryptChunks = m_statDecryptChunks;
+    stats.readNs = m_statReadNs;
+    uint64_t sourceNs = m_statSourceNs;
+    stats.decodeNs = (sourceNs > stats.readNs) ? sourceNs - stats.readNs : 0;
+    stats.convertNs = m_statConvertNs;
+    stats.analyzeNs = m_statAnalyzeNs;
+    stats.dspNs = m_statDspNs;
+    stats.framesRendered = m_statFrames;
+    stats.callbacks = m_statCallbacks;
+    stats.underruns = m_statUnderruns;
+    stats.underrunFrames = m_statUnderrunFrames;
+    if (m_firstAudioNs != 0) stats.firstAudioMs = m_firstAudioNs / 1e6;
+    if (m_seekLatencyNs != 0) stats.lastSeekMs = m_seekLatencyNs / 1e6;
+    stats.finished = m_finished;
+    return stats;
+}
+
+void AudioPlayer::resetPipelineStats() {
+    m_statDecryptNs = 0;
+    m_statDecryptChunks = 0;
+    m_statReadNs = 0;
+    m_statSourceNs = 0;
+    m_statConvertNs = 0;
+    m_statAnalyzeNs = 0;
+    m_statDspNs = 0;
+    m_statFrames = 0;
+    m_statCallbacks = 0;
+    m_statUnderruns = 0;
+    m_statUnderrunFrames = 0;
+    m_firstAudioNs = 0;
+    m_seekStartNs = 0;
+    m_seekLatencyNs = 0;
+    m_finished = false;
+}
+
+ma_uint64 AudioPlayer::getCursorFrames() {
+    return m_pcmCursor;
+}
+
+void AudioPlayer::setHistorySeconds(float seconds) {
+    m_historySeconds = (seconds < 0.0f) ? 0.0f : (seconds > 300.0f) ? 300.0f : seconds;
+}
+
+std::string AudioPlayer::getHistoryInfo() {
+    std::stringstream ss;
+    ss << std::fixed;
+    ss.precision(1);
+    ss << "History: " << m_historySeconds << " s window";
+    // Lock-free snapshot: taking m_decoderMutex here would cost the device a period
+    if (m_attached && m_sourceRate > 0) {
+        ss << ", holding " << (double)m_historyHeld / m_sourceRate << " s in "
+           << (double)m_history.memoryBytes() / (1024.0 * 1024.0) << " MiB";
+    }
+    uint64_t hits = m_historyHits, misses = m_historyMisses;
+    ss << ", seeks served from history " << hits << "/" << (hits + misses);
+    if (hits + misses > 0) ss << " (" << (100.0 * hits / (hits + misses)) << "%)";
+    return ss.str();
+}
+
 void AudioPlayer::playbackLoop(std::string path) {
     std::cout << "[AudioPlayer] Playback monitor started" << std::endl;
     
@@ -441,8 +853,8 @@ void AudioPlayer::playbackLoop(std::string path) {
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
         
         // ma_uint64 cursor, total;
-        // ma_decoder_get_cursor_in_pcm_frames(&g_ctx.decoder, &cursor);
-        // ma_decoder_get_length_in_pcm_frames(&g_ctx.decoder, &total);
+        // ma_decoder_get_cursor_in_pcm_frames(&m_decoder, &cursor);
+        // ma_decoder_get_length_in_pcm_frames(&m_decoder, &total);
         
         // if (cursor >= total && total > 0) {
         //    std::cout << "\n[AudioPlayer] Window finished, checking for more..." << std::endl;
@@ -464,6 +876,7 @@ void AudioPlayer::playbackLoop(std::string path) {
 
 void AudioPlayer::decryptionLoop(std::string path) {
     std::cout << "[AudioPlayer] [" << this << "] Decryption thread started" << std::endl;
+    Realtime::applyToCurrentThread(Realtime::Role::Decrypt);
     
     // Define max buffer size (e.g., 20 chunks ~ 20MB)
     const size_t MAX_BUFFER_CHUNKS = 20;
@@ -482,7 +895,8 @@ void AudioPlayer::decryptionLoop(std::string path) {
                 lock.unlock(); // Unlock for IO
                 
                 std::cout << "[AudioPlayer] Executing seek to chunk " << target << std::endl;
-                Abby::AbbyCrypt::seekToChunk(target);
+                m_stream.seekToChunk(target);
+                m_decryptDone = false;
                 
                 lock.lock();
                 m_rollingBuffer.clear();
@@ -499,13 +913,16 @@ void AudioPlayer::decryptionLoop(std::string path) {
         
         if (m_stopSignal) break;
 
-        size_t currentChunk = Abby::AbbyCrypt::getCurrentChunk();
+        size_t currentChunk = m_stream.getCurrentChunk();
         
         // Decrypt next chunk if available
         if (currentChunk < m_totalChunks) {
             std::vector<unsigned char> newChunk;
             try {
-                newChunk = Abby::AbbyCrypt::decryptNextChunk();
+                uint64_t cpu0 = threadCpuNs();
+                newChunk = m_stream.decryptNextChunk();
+                m_statDecryptNs += threadCpuNs() - cpu0;
+                m_statDecryptChunks++;
             } catch (const std::exception& e) {
                 std::cerr << "[AudioPlayer] Decryption Error: " << e.what() << std::endl;
                 m_lastError = "Decryption Failed";
@@ -515,35 +932,41 @@ void AudioPlayer::decryptionLoop(std::string path) {
             }
             
             if (!newChunk.empty()) {
-                std::lock_guard<std::mutex> lock(m_bufferMutex);
-                
-                // Add new chunk
-                AudioChunk ac;
-                ac.data = std::move(newChunk);
-                ac.chunkIndex = currentChunk;
-                
                 // Debug dump first chunk's header
-                if (currentChunk == 0 && !ac.data.empty()) {
+                if (currentChunk == 0) {
                     std::cout << "[AudioPlayer] [" << this << "] First Chunk Header (32 bytes): ";
-                    for(size_t i=0; i<32 && i<ac.data.size(); i++) {
+                    for(size_t i=0; i<32 && i<newChunk.size(); i++) {
                         char buf[4];
-                        sprintf(buf, "%02X ", ac.data[i]);
+                        sprintf(buf, "%02X ", newChunk[i]);
                         std::cout << buf;
                     }
                     std::cout << std::endl;
                 }
                 
-                m_rollingBuffer.push_back(std::move(ac));
-                
-                m_bufferCV.notify_all(); // Notify reader
+                // Logging stays outside: the device thread takes this lock, a slow stdout must not stall it
+                size_t buffered;
+                {
+                    std::lock_guard<std::mutex> lock(m_bufferMutex);
+                    AudioChunk ac;
+                    ac.data = std::move(newChunk);
+                    ac.chunkIndex = currentChunk;
+                    m_rollingBuffer.push_back(std::move(ac));
+                    buffered = m_rollingBuffer.size();
+                    m_bufferCV.notify_all(); // Notify reader
+                }
                 
                 // Debug log occasionally
-                if (m_rollingBuffer.size() % 5 == 0) {
-                     std::cout << "[AudioPlayer] [" << this << "] Buffered " << m_rollingBuffer.size() << " chunks. Next: " << currentChunk + 1 << std::endl;
+                if (buffered % 5 == 0) {
+                     std::cout << "[AudioPlayer] [" << this << "] Buffered " << buffered << " chunks. Next: " << currentChunk + 1 << std::endl;
                 }
             }
         } else {
             // End of File reached, just wait
+            if (!m_decryptDone) {
+                std::lock_guard<std::mutex> lock(m_bufferMutex);
+                if (!m_seekRequested) m_decryptDone = true;
+                m_bufferCV.notify_all(); // Readers stop waiting for more data
+            }
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
@@ -9,15 +9,22 @@
 #include <condition_variable>
 #include <deque>
 #include "FrequencyAnalyzer.hpp"
+#include "AudioDsp.hpp"
+#include "AudioMixer.hpp"
+#include "PcmHistory.hpp"
+#include "AbbyCrypt.hpp"
 
 #define ROLLING_BUFFER_CHUNKS 5  // 5 seconds of lookahead
 
-class AudioPlayer {
+// Each instance owns its stream, decoder and threads; any number of players
+// can run at once and are summed by the (shared) AudioMixer.
+class AudioPlayer : public AudioMixer::Source {
 public:
-    AudioPlayer();
+    explicit AudioPlayer(std::shared_ptr<AudioMixer> mixer = nullptr);
     ~AudioPlayer();
     
     std::shared_ptr<FrequencyAnalyzer> getAnalyzer() { return m_analyzer; }
+    AudioDsp& getDsp() { return m_dsp; }
 
     void play(const std::string& filepath);
     void stop();
@@ -26,9 +33,17 @@ public:
     void seek(float seconds);
     void setVolume(float volume); // 0.0 - 1.0
     float getVolume() const;
+    // ReplayGain: auto (the default) brings every track with embedded analysis to
+    // REFERENCE_LOUDNESS_DB, limited by its peak so it does not clip; tracks without
+    // analysis play at 0 dB. A fixed gain applies to every track until 'auto' again.
+    static constexpr float REFERENCE_LOUDNESS_DB = -18.0f;
+    void setReplayGain(float db);
+    void setReplayGainAuto();
+    std::string getReplayGainInfo() const;
     
     std::string getStatus();
     std::string getLastError() const { return m_lastError; }
+    std::string getOutputInfo() const;
 
     struct PlaybackState {
         float currentTime = 0.0f;
@@ -39,13 +54,61 @@ public:
     };
     
     PlaybackState getPlaybackState();
+    // Exact length of the current track. totalTime is only an estimate for encoded
+    // streams; this asks the decoder, which scans an MP3 without a Xing/LAME header
+    // once (silence meanwhile). For tools, not for the playback path.
+    double getLengthSeconds();
+
+    // Per-stage cost counters (see abby-pipeline-bench). Times are nanoseconds
+    // summed over the track; decrypt is thread CPU time, the rest run on the
+    // device thread.
+    struct PipelineStats {
+        uint64_t decryptNs = 0;
+        uint64_t decryptChunks = 0;
+        uint64_t readNs = 0;          // Rolling buffer copies, including waits
+        uint64_t decodeNs = 0;        // Decoder / raw PCM source, excluding readNs
+        uint64_t convertNs = 0;
+        uint64_t analyzeNs = 0;       // Analyzer tap only; the FFT runs on its own thread
+        uint64_t dspNs = 0;
+        uint64_t framesRendered = 0;  // Frames handed to the mixer
+        uint64_t callbacks = 0;
+        uint64_t underruns = 0;       // Short reads before the end of the track
+        uint64_t underrunFrames = 0;
+        double firstAudioMs = -1.0;   // play() until the first frame was rendered
+        double lastSeekMs = -1.0;     // seek() until the first frame after it
+        bool finished = false;        // Whole track rendered
+    };
+    PipelineStats getPipelineStats() const;
+    void resetPipelineStats();
+
+    // Decoded PCM kept for instant backward seeks; size applies from the next track
+    void setHistorySeconds(float seconds);
+    float getHistorySeconds() const { return m_historySeconds; }
+    std::string getHistoryInfo();
+
     bool isPlaying() const { return m_isPlaying && !m_isPaused; }
     bool isPaused() const { return m_isPaused; }
 
+    // AudioMixer::Source
+    ma_uint32 readFrames(void* pOutput, ma_uint32 frameCount) override;
+
 private:
     void playbackLoop(std::string path);
     void decryptionLoop(std::string path);
 
+    // Rolling buffer access shared by the decoder callbacks and the raw PCM path.
+    // waitMs == 0 (device thread) only try_locks: a busy buffer reads as nothing.
+    size_t readBuffered(void* pBufferOut, size_t bytesToRead, int waitMs);
+    // Caller holds m_bufferMutex; never waits
+    size_t takeBuffered(void* pBufferOut, size_t bytesToRead);
+    bool hasBufferedLocked(size_t bytes) const;
+    void seekToStreamPos(size_t targetPos);
+    ma_uint64 getCursorFrames();
+
+    ma_uint32 readSourceFrames(void* pOutput, ma_uint32 frameCount);
+    ma_uint32 readConverted(void* pOutput, ma_uint32 frameCount);
+    void abortPlayback();
+
     // Miniaudio callbacks
     static ma_result ds_read(ma_decoder* pDecoder, void* pBufferOut, size_t bytesToRead, size_t* pBytesRead);
     static ma_result ds_seek(ma_decoder* pDecoder, ma_int64 byteOffset, ma_seek_origin origin);
@@ -54,6 +117,12 @@ private:
     std::atomic<bool> m_isPaused;
     std::atomic<bool> m_stopSignal;
     std::atomic<float> m_volume;
+    std::atomic<bool> m_replayGainAuto{true};
+    std::atomic<float> m_replayGainDb{0.0f};   // Fixed gain, when not auto
+    std::atomic<float> m_trackGainDb{0.0f};    // Auto gain of the current track
+    std::atomic<float> m_trackLoudnessDb{0.0f};
+    std::atomic<bool> m_trackGainKnown{false}; // Current track carries analysis
+    void applyReplayGain();
     std::thread m_playbackWorker;
     std::thread m_decryptionWorker;
     
@@ -77,6 +146,40 @@ private:
     
     std::string m_currentFilePath;
     std::string m_lastError;
+
+    // Per-instance playback state (device thread reads these through readFrames)
+    std::shared_ptr<AudioMixer> m_mixer;
+    Abby::TrackStream m_stream;
+    ma_decoder m_decoder;
+    bool m_hasDecoder = false;
+    std::mutex m_decoderMutex;               // Held by seek(); the device thread only try_locks
+    bool m_decoderHoldsBuffer = false;       // Device thread decodes under m_bufferMutex, ds_read must not lock
+    bool m_rawPcm = false;
+    ma_format m_sourceFormat = ma_format_s16;
+    ma_uint32 m_sourceChannels = 0;
+    ma_uint32 m_sourceRate = 0;
+    AudioMixer::Format m_outFormat;
+    ma_data_converter m_converter;
+    bool m_hasConverter = false;
+    std::vector<unsigned char> m_convertScratch;
+    std::atomic<bool> m_attached;
+    std::atomic<ma_uint64> m_pcmCursor;      // Next source frame handed to the mixer
+    PcmHistory m_history;                    // Guarded by m_decoderMutex
+    std::atomic<float> m_historySeconds{30.0f};
+    std::atomic<uint64_t> m_historyHits{0}, m_historyMisses{0};
+    std::atomic<ma_uint64> m_historyHeld{0};
+    std::atomic<bool> m_decryptDone;         // Last chunk queued: a short read is the end, not an underrun
+
+    // PipelineStats counters
+    std::atomic<uint64_t> m_statDecryptNs{0}, m_statDecryptChunks{0};
+    std::atomic<uint64_t> m_statReadNs{0}, m_statSourceNs{0}, m_statConvertNs{0};
+    std::atomic<uint64_t> m_statAnalyzeNs{0}, m_statDspNs{0};
+    std::atomic<uint64_t> m_statFrames{0}, m_statCallbacks{0};
+    std::atomic<uint64_t> m_statUnderruns{0}, m_statUnderrunFrames{0};
+    std::atomic<uint64_t> m_playStartNs{0}, m_firstAudioNs{0};
+    std::atomic<uint64_t> m_seekStartNs{0}, m_seekLatencyNs{0};
+    std::atomic<bool> m_finished{false};
     
     std::shared_ptr<FrequencyAnalyzer> m_analyzer;
+    AudioDsp m_dsp;
 };
@@ -0,0 +1,176 @@
+#include "BandMapper.hpp"
+#include <algorithm>
+#include <cmath>
+
+static float hzToMel(float hz) { return 2595.0f * std::log10(1.0f + hz / 700.0f); }
+static float melToHz(float mel) { return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f); }
+
+bool BandMapper::parseLayout(const std::string& name, Layout& layout) {
+    if (name == "linear") layout = Layout::Linear;
+    else if (name == "log") layout = Layout::Log;
+    else if (name == "mel") layout = Layout::Mel;
+    else if (name == "third-octave" || name == "1/3") layout = Layout::ThirdOctave;
+    else if (name == "cq" || name == "constant-q") layout = Layout::ConstantQ;
+    else return false;
+    return true;
+}
+
+const char* BandMapper::layoutName(Layout layout) {
+    switch (layout) {
+        case Layout::Linear:      return "linear";
+        case Layout::Log:         return "log";
+        case Layout::Mel:         return "mel";
+        case Layout::ThirdOctave: return "third-octave";
+        case Layout::ConstantQ:   return "cq";
+    }
+    return "?";
+}
+
+bool BandMapper::matches(Layout layout, int bands, int fftSize, float sampleRate) const {
+    return !m_offsets.empty() && m_layout == layout && m_requestedBands == bands &&
+           m_fftSize == fftSize && m_sampleRate == sampleRate;
+}
+
+void BandMapper::build(Layout layout, int bands, int fftSize, float sampleRate) {
+    m_layout = layout;
+    m_requestedBands = bands;
+    m_fftSize = fftSize;
+    m_sampleRate = sampleRate;
+    m_bins = fftSize / 2;
+    m_binHz = sampleRate / fftSize;
+    m_offsets.assign(1, 0);
+    m_bin.clear();
+    m_weight.clear();
+
+    const float nyquist = sampleRate * 0.5f;
+    const float lo = MIN_HZ;
+    const float hi = std::min(MAX_HZ, nyquist);
+    std::vector<float> w(m_bins, 0.0f);
+
+    switch (layout) {
+        case Layout::Linear:
+            for (int b = 0; b < bands; ++b) {
+                addRect(w, nyquist * b / bands, nyquist * (b + 1) / bands);
+                commit(w);
+            }
+            break;
+
+        case Layout::Log:
+            for (int b = 0; b < bands; ++b) {
+                addRect(w, lo * std::pow(hi / lo, (float)b / bands), lo * std::pow(hi / lo, (float)(b + 1) / bands));
+                commit(w);
+            }
+            break;
+
+        case Layout::Mel: {
+            float melLo = hzToMel(lo), melHi = hzToMel(hi);
+            float step = (melHi - melLo) / (bands + 1);
+            for (int b = 0; b < bands; ++b) {
+                addTriangle(w, melToHz(melLo + step * b), melToHz(melLo + step * (b + 1)), melToHz(melLo + step * (b + 2)));
+                commit(w);
+            }
+            break;
+        }
+
+        case Layout::ThirdOctave: {
+            // ISO base-10 centres 10^(n/10): ..., 31.5, 40, 50, 63, 80, 100 Hz, ...
+            int first = (int)std::ceil(10.0f * std::log10(lo));
+            int last = (int)std::floor(10.0f * std::log10(hi));
+            const float edge = std::pow(2.0f, 1.0f / 6.0f);
+            for (int n = first; n <= last; ++n) {
+                float centre = std::pow(10.0f, n / 10.0f);
+                addRect(w, centre / edge, centre * edge);
+                commit(w);
+            }
+            break;
+        }
+
+        case Layout::ConstantQ: {
+            // Centre spacing ratio r gives Q = 1 / (r - 1); kernels overlap their neighbours
+            float ratio = std::pow(hi / lo, 1.0f / bands);
+            for (int b = 0; b < bands; ++b) {
+                float centre = lo * std::pow(ratio, b + 0.5f);
+                addHann(w, centre, centre * (ratio - 1.0f));
+                commit(w);
+            }
+            break;
+        }
+    }
+}
+
+void BandMapper::map(const float* magnitudes, float* out) const {
+    const int count = bands();
+    for (int b = 0; b < count; ++b) {
+        float sum = 0.0f;
+        for (int e = m_offsets[b]; e < m_offsets[b + 1]; ++e) {
+            sum += m_weight[e] * magnitudes[m_bin[e]];
+        }
+        out[b] = sum;
+    }
+}
+
+// Bin k covers [(k - 0.5) * binHz, (k + 0.5) * binHz]; weight = overlap with [lo, hi]
+void BandMapper::addRect(std::vector<float>& w, float lo, float hi) const {
+    if (hi - lo < m_binHz) {
+        addInterpolated(w, 0.5f * (lo + hi));
+        return;
+    }
+    int first = std::max(0, (int)std::floor(lo / m_binHz - 0.5f));
+    int last = std::min(m_bins - 1, (int)std::ceil(hi / m_binHz + 0.5f));
+    for (int k = first; k <= last; ++k) {
+        float overlap = std::min(hi, (k + 0.5f) * m_binHz) - std::max(lo, (k - 0.5f) * m_binHz);
+        if (overlap > 0.0f) w[k] += overlap;
+    }
+}
+
+void BandMapper::addTriangle(std::vector<float>& w, float lo, float centre, float hi) const {
+    int first = std::max(0, (int)std::ceil(lo / m_binHz));
+    int last = std::min(m_bins - 1, (int)std::floor(hi / m_binHz));
+    int used = 0;
+    for (int k = first; k <= last; ++k) {
+        float f = k * m_binHz;
+        float weight = (f <= centre) ? (f - lo) / (centre - lo) : (hi - f) / (hi - centre);
+        if (weight > 0.0f) {
+            w[k] += weight;
+            used++;
+        }
+    }
+    if (used < 2) addInterpolated(w, centre);
+}
+
+void BandMapper::addHann(std::vector<float>& w, float centre, float halfWidth) const {
+    int first = std::max(0, (int)std::ceil((centre - halfWidth) / m_binHz));
+    int last = std::min(m_bins - 1, (int)std::floor((centre + halfWidth) / m_binHz));
+    int used = 0;
+    for (int k = first; k <= last; ++k) {
+        float x = (k * m_binHz - centre) / halfWidth;
+        float weight = 0.5f * (1.0f + std::cos(3.14159265f * x));
+        if (weight > 1e-4f) {
+            w[k] += weight;
+            used++;
+        }
+    }
+    if (used < 2) addInterpolated(w, centre);
+}
+
+void BandMapper::addInterpolated(std::vector<float>& w, float hz) const {
+    float x = std::min(std::max(hz / m_binHz, 0.0f), (float)(m_bins - 1));
+    int k = std::min((int)x, m_bins - 2);
+    float frac = x - k;
+    w[k] += 1.0f - frac;
+    w[k + 1] += frac;
+}
+
+// Move the dense weights of one band into the table, normalised to sum 1
+void BandMapper::commit(std::vector<float>& w) {
+    float total = 0.0f;
+    for (float v : w) total += v;
+    for (int k = 0; k < m_bins; ++k) {
+        if (w[k] > 0.0f) {
+            m_bin.push_back(k);
+            m_weight.push_back(w[k] / total);
+            w[k] = 0.0f;
+        }
+    }
+    m_offsets.push_back((int)m_bin.size());
+}
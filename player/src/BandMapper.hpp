@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * BandMapper - FFT bins to display bands through a sparse weight table
+ *
+ * The table is built once per (layout, bands, FFT size, sample rate); map()
+ * is then a plain weighted sum over a few entries per band. Bands narrower
+ * than one bin interpolate between the two nearest bins instead of
+ * repeating a single bin, so the bass stays smooth at small FFT sizes.
+ *
+ * Layouts:
+ *   linear       equal width from DC to Nyquist (the original mapping)
+ *   log          geometric spacing between MIN_HZ and MAX_HZ
+ *   mel          triangular mel filter bank
+ *   third-octave ISO 1/3-octave bands; fixed count, widened to 'bands'
+ *   cq           constant-Q, Hann kernels of width centre / Q
+ */
+class BandMapper {
+public:
+    enum class Layout { Linear, Log, Mel, ThirdOctave, ConstantQ };
+
+    static constexpr float MIN_HZ = 30.0f;
+    static constexpr float MAX_HZ = 16000.0f;
+
+    static bool parseLayout(const std::string& name, Layout& layout);
+    static const char* layoutName(Layout layout);
+
+    void build(Layout layout, int bands, int fftSize, float sampleRate);
+    bool matches(Layout layout, int bands, int fftSize, float sampleRate) const;
+
+    // magnitudes: fftSize / 2 bins; out: bands() values
+    void map(const float* magnitudes, float* out) const;
+    int bands() const { return (int)m_offsets.size() - 1; }
+
+private:
+    void addRect(std::vector<float>& w, float lo, float hi) const;
+    void addTriangle(std::vector<float>& w, float lo, float centre, float hi) const;
+    void addHann(std::vector<float>& w, float centre, float halfWidth) const;
+    void addInterpolated(std::vector<float>& w, float hz) const;
+    void commit(std::vector<float>& w);
+
+    Layout m_layout = Layout::Linear;
+    int m_requestedBands = 0;
+    int m_fftSize = 0;
+    float m_sampleRate = 0.0f;
+    float m_binHz = 0.0f;
+    int m_bins = 0;
+
+    // CSR layout: band b uses entries [m_offsets[b], m_offsets[b + 1])
+    std::vector<int> m_offsets;
+    std::vector<int> m_bin;
+    std::vector<float> m_weight;
+};
@@ -0,0 +1,227 @@
+#include "FeatureExtractor.hpp"
+#include <algorithm>
+#include <cmath>
+
+static const float BAND_EDGES_HZ[5] = { 20.0f, 250.0f, 1000.0f, 4000.0f, 16000.0f };
+static const float ENVELOPE_SECONDS = 6.0f;
+static const float TEMPO_INTERVAL_SECONDS = 0.5f;
+static const float MIN_BPM = 60.0f;
+static const float MAX_BPM = 200.0f;
+
+void AudioFeatures::packUniforms(float* out) const {
+    float nyquist = sampleRate > 0.0f ? sampleRate * 0.5f : 1.0f;
+    const float packed[UNIFORM_VEC4S * 4] = {
+        rms, peak, onset, flux,
+        bass, lowMid, highMid, treble,
+        std::min(centroid / nyquist, 1.0f), beatPhase, bpm, beatConfidence,
+        correlation, balance, width, 0.0f
+    };
+    std::copy(packed, packed + UNIFORM_VEC4S * 4, out);
+}
+
+void FeatureExtractor::reset(int fftSize, int hopSize, float sampleRate) {
+    m_bins = fftSize / 2;
+    m_sampleRate = sampleRate;
+    m_binHz = sampleRate / fftSize;
+    m_hopSeconds = hopSize / sampleRate;
+    m_ampScale = 4.0f / fftSize;
+    // Auto-gain maxima halve in about five seconds
+    m_decay = std::pow(0.5f, m_hopSeconds / 5.0f);
+
+    for (int i = 0; i < 5; ++i) {
+        m_bandEdges[i] = std::min(m_bins, std::max(1, (int)std::lround(BAND_EDGES_HZ[i] / m_binHz)));
+    }
+    std::fill(m_bandMax, m_bandMax + 4, 0.0f);
+    m_fluxMax = 0.0f;
+    m_fluxMean = 0.0f;
+    m_prevLog.assign(m_bins, 0.0f);
+
+    size_t length = (size_t)std::max(64.0f, ENVELOPE_SECONDS / m_hopSeconds);
+    m_envelope.assign(length, 0.0f);
+    m_linear.assign(length, 0.0f);
+    m_envPos = 0;
+    m_envCount = 0;
+    m_hopsSinceTempo = 0;
+
+    m_period = 0.0f;
+    m_phase = 0.0f;
+    m_confidence = 0.0f;
+}
+
+void FeatureExtractor::process(const float* hop, int hopCount, const float* magnitudes, AudioFeatures& out) {
+    // Time domain
+    float sumSq = 0.0f, peak = 0.0f;
+    for (int i = 0; i < hopCount; ++i) {
+        sumSq += hop[i] * hop[i];
+        peak = std::max(peak, std::fabs(hop[i]));
+    }
+    out.rms = hopCount > 0 ? std::sqrt(sumSq / hopCount) : 0.0f;
+    out.peak = peak;
+
+    // Band energies, centroid, dominant bin and flux in one pass over the bins
+    float bandSq[4] = {};
+    float weighted = 0.0f, total = 0.0f, flux = 0.0f, maxMag = -1.0f;
+    int maxBin = 0;
+    for (int k = 1; k < m_bins; ++k) {
+        float amp = magnitudes[k] * m_ampScale;
+        weighted += k * amp;
+        total += amp;
+        if (amp > maxMag) {
+            maxMag = amp;
+            maxBin = k;
+        }
+
+        // Log compression keeps quiet passages from being all-or-nothing
+        float logMag = std::log1p(1000.0f * amp);
+        flux += std::max(0.0f, logMag - m_prevLog[k]);
+        m_prevLog[k] = logMag;
+    }
+    for (int b = 0; b < 4; ++b) {
+        for (int k = m_bandEdges[b]; k < m_bandEdges[b + 1]; ++k) {
+            float amp = magnitudes[k] * m_ampScale;
+            bandSq[b] += amp * amp;
+        }
+    }
+    flux /= std::max(1, m_bins - 1);
+
+    float* bands[4] = { &out.bass, &out.lowMid, &out.highMid, &out.treble };
+    for (int b = 0; b < 4; ++b) {
+        float level = std::sqrt(bandSq[b]);
+        m_bandMax[b] = std::max(level, std::max(m_bandMax[b] * m_decay, 1e-4f));
+        *bands[b] = level / m_bandMax[b];
+    }
+    out.centroid = total > 0.0f ? weighted / total * m_binHz : 0.0f;
+    out.dominantHz = maxBin * m_binHz;
+    out.sampleRate = m_sampleRate;
+
+    m_fluxMax = std::max(flux, std::max(m_fluxMax * m_decay, 1e-4f));
+    out.flux = flux / m_fluxMax;
+
+    // Onset: flux above its recent mean (~0.25 s time constant)
+    float novelty = std::max(0.0f, flux - m_fluxMean);
+    m_fluxMean += (flux - m_fluxMean) * std::min(1.0f, m_hopSeconds / 0.25f);
+    out.onset = std::min(1.0f, novelty / m_fluxMax * 2.0f);
+
+    m_envelope[m_envPos] = novelty;
+    m_envPos = (m_envPos + 1) % m_envelope.size();
+    m_envCount = std::min(m_envCount + 1, m_envelope.size());
+
+    if (++m_hopsSinceTempo * m_hopSeconds >= TEMPO_INTERVAL_SECONDS) {
+        m_hopsSinceTempo = 0;
+        estimateTempo();
+    } else if (m_period > 0.0f) {
+        m_phase += 1.0f;
+        if (m_phase >= m_period) m_phase -= m_period;
+    }
+
+    out.bpm = m_period > 0.0f ? 60.0f / (m_period * m_hopSeconds) : 0.0f;
+    out.beatPhase = m_period > 0.0f ? m_phase / m_period : 0.0f;
+    out.beatConfidence = m_confidence;
+}
+
+void FeatureExtractor::processStereo(const float* left, const float* right, int count, AudioFeatures& out) {
+    double ll = 0.0, rr = 0.0, lr = 0.0;
+    for (int i = 0; i < count; ++i) {
+        ll += left[i] * left[i];
+        rr += right[i] * right[i];
+        lr += left[i] * right[i];
+    }
+    double norm = std::sqrt(ll * rr);
+    out.correlation = norm > 1e-12 ? (float)(lr / norm) : 0.0f;
+
+    double levelL = std::sqrt(ll), levelR = std::sqrt(rr);
+    out.balance = (levelL + levelR) > 1e-6 ? (float)((levelR - levelL) / (levelL + levelR)) : 0.0f;
+
+    // Mid/side energies follow from the same sums: (l +- r)^2 / 4
+    double mid = std::sqrt(std::max(0.0, (ll + rr + 2.0 * lr) * 0.25));
+    double side = std::sqrt(std::max(0.0, (ll + rr - 2.0 * lr) * 0.25));
+    out.width = (mid + side) > 1e-6 ? (float)(side / (mid + side)) : 0.0f;
+}
+
+void FeatureExtractor::estimateTempo() {
+    const size_t size = m_envelope.size();
+    int minLag = (int)std::floor(60.0f / MAX_BPM / m_hopSeconds);
+    int maxLag = (int)std::ceil(60.0f / MIN_BPM / m_hopSeconds);
+    // Need at least two periods of the slowest tempo
+    if (minLag < 1 || m_envCount < (size_t)maxLag * 2) return;
+    maxLag = std::min(maxLag, (int)m_envCount / 2);
+
+    // Oldest first, zero-mean
+    const int n = (int)m_envCount;
+    float mean = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        m_linear[i] = m_envelope[(m_envPos + size - n + i) % size];
+        mean += m_linear[i];
+    }
+    mean /= n;
+    for (int i = 0; i < n; ++i) m_linear[i] -= mean;
+
+    auto autocorr = [&](int lag) {
+        float sum = 0.0f;
+        for (int i = lag; i < n; ++i) sum += m_linear[i] * m_linear[i - lag];
+        return sum / (n - lag);
+    };
+    float energy = autocorr(0);
+    if (energy <= 1e-12f) {
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Perceptual prior: log-Gaussian around 120 BPM, one octave wide
+    auto weighted = [&](int lag) {
+        float octaves = std::log2(60.0f / (lag * m_hopSeconds) / 120.0f);
+        return autocorr(lag) * std::exp(-0.5f * octaves * octaves);
+    };
+    int bestLag = 0;
+    float bestScore = 0.0f;
+    for (int lag = minLag; lag <= maxLag; ++lag) {
+        float score = weighted(lag);
+        if (score > bestScore) {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+    if (bestLag == 0) {
+        m_confidence = 0.0f;
+        return;
+    }
+
+    // Parabolic interpolation for a fractional period
+    float period = (float)bestLag;
+    float before = bestLag > 1 ? weighted(bestLag - 1) : bestScore;
+    float after = weighted(bestLag + 1);
+    float denom = before - 2.0f * bestScore + after;
+    if (denom < 0.0f) period += 0.5f * (before - after) / denom;
+    m_confidence = std::min(1.0f, std::max(0.0f, autocorr(bestLag) / energy));
+
+    // Phase: offset whose comb of past beats collects the most onset energy
+    int whole = std::max(1, (int)period);
+    int combs = std::min(4, (int)((n - 1) / period));
+    int bestOffset = 0;
+    float bestComb = -1e30f;
+    for (int offset = 0; offset < whole; ++offset) {
+        float comb = 0.0f;
+        for (int k = 0; k < combs; ++k) {
+            int index = n - 1 - offset - (int)std::lround(k * period);
+            if (index >= 0) comb += m_linear[index];
+        }
+        if (comb > bestComb) {
+            bestComb = comb;
+            bestOffset = offset;
+        }
+    }
+
+    if (m_period <= 0.0f) {
+        m_phase = (float)bestOffset;
+    } else {
+        // Pull towards the measured phase along the shorter way round, avoids visible jumps
+        float phase = m_phase + 1.0f;
+        float diff = bestOffset - phase;
+        if (diff > period * 0.5f) diff -= period;
+        if (diff < -period * 0.5f) diff += period;
+        m_phase = phase + diff * 0.5f;
+    }
+    m_period = period;
+    while (m_phase >= m_period) m_phase -= m_period;
+    while (m_phase < 0.0f) m_phase += m_period;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/**
+ * AudioFeatures - Compact per-hop description of the playing audio
+ *
+ * Computed once per analysis hop so shaders read a few uniforms instead of
+ * sampling u_spectrum many times per pixel. Levels marked "auto-gained" are
+ * divided by a slowly decaying running maximum and stay within 0..1 at any
+ * playback volume.
+ */
+struct AudioFeatures {
+    float rms = 0.0f;            // Last hop, 1.0 = full scale
+    float peak = 0.0f;
+    float onset = 0.0f;          // Spectral flux above its running mean, 0..1
+    float flux = 0.0f;           // Positive spectral change, auto-gained
+
+    float bass = 0.0f;           // 20-250 Hz, auto-gained
+    float lowMid = 0.0f;         // 250-1000 Hz
+    float highMid = 0.0f;        // 1-4 kHz
+    float treble = 0.0f;         // 4-16 kHz
+
+    float centroid = 0.0f;       // Spectral centroid, Hz
+    float beatPhase = 0.0f;      // 0 on a beat, rising towards 1 before the next
+    float bpm = 0.0f;            // 0 until a tempo was found
+    float beatConfidence = 0.0f; // 0..1
+
+    float dominantHz = 0.0f;     // Strongest bin (excluding DC)
+    float sampleRate = 0.0f;
+
+    float correlation = 0.0f;    // Left/right, -1..1 (1 = mono, 0 = silence or unrelated)
+    float balance = 0.0f;        // -1 = left only .. 1 = right only
+    float width = 0.0f;          // Side / (mid + side) level, 0 = mono
+
+    static const int FLOAT_COUNT = 17;
+
+    // uniform vec4 u_features[UNIFORM_VEC4S]:
+    //   [0] rms, peak, onset, flux
+    //   [1] bass, lowMid, highMid, treble
+    //   [2] centroid (0..1 of Nyquist), beatPhase, bpm, beatConfidence
+    //   [3] correlation, balance, width, 0
+    static const int UNIFORM_VEC4S = 4;
+    void packUniforms(float* out) const;
+};
+
+/**
+ * FeatureExtractor - Builds AudioFeatures from the analysis thread's hops
+ *
+ * Tempo comes from the autocorrelation of the onset envelope over the last
+ * few seconds (re-estimated twice a second, weighted towards 120 BPM); the
+ * beat phase is anchored to the strongest comb of onsets at that period
+ * and advances by one hop per call in between.
+ */
+class FeatureExtractor {
+public:
+    void reset(int fftSize, int hopSize, float sampleRate);
+
+    // hop: newest time-domain samples; magnitudes: fftSize / 2 raw (un-normalized) bins
+    void process(const float* hop, int hopCount, const float* magnitudes, AudioFeatures& out);
+
+    // Stereo fields only, from the two channels of one analysis window
+    static void processStereo(const float* left, const float* right, int count, AudioFeatures& out);
+
+private:
+    void estimateTempo();
+
+    int m_bins = 0;
+    float m_sampleRate = 0.0f;
+    float m_binHz = 0.0f;
+    float m_hopSeconds = 0.0f;
+    float m_ampScale = 0.0f;       // Hann-windowed bin magnitude -> sine amplitude
+    float m_decay = 1.0f;          // Per-hop decay of the auto-gain maxima
+
+    int m_bandEdges[5] = {};       // Bin ranges of the four bands
+    float m_bandMax[4] = {};
+    float m_fluxMax = 0.0f;
+    float m_fluxMean = 0.0f;
+    std::vector<float> m_prevLog;
+
+    // Onset envelope ring at hop rate
+    std::vector<float> m_envelope;
+    std::vector<float> m_linear;   // Scratch: envelope oldest-first
+    size_t m_envPos = 0;
+    size_t m_envCount = 0;
+    int m_hopsSinceTempo = 0;
+
+    float m_period = 0.0f;         // Beat period in hops (0 = unknown)
+    float m_phase = 0.0f;          // Hops since the last beat
+    float m_confidence = 0.0f;
+};
@@ -0,0 +1,83 @@
+#include "FeedbackBuffer.hpp"
+#include <iostream>
+
+FeedbackBuffer::FeedbackBuffer(GLuint unit) : m_unit(unit) {}
+
+bool FeedbackBuffer::create() {
+    if (!(GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object)) return false;
+    glGenFramebuffers(2, m_framebuffers);
+    glGenFramebuffers(1, &m_copyFramebuffer);
+    return true;
+}
+
+bool FeedbackBuffer::begin(int width, int height) {
+    if ((width != m_width || height != m_height) && !resize(width, height)) return false;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[1 - m_previous]);
+    return true;
+}
+
+void FeedbackBuffer::end() {
+    m_previous = 1 - m_previous;
+    glActiveTexture(GL_TEXTURE0 + m_unit);
+    glBindTexture(GL_TEXTURE_2D, m_textures[m_previous]);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void FeedbackBuffer::clear() {
+    if (m_width == 0) return;
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    for (GLuint framebuffer : m_framebuffers) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool FeedbackBuffer::resize(int width, int height) {
+    GLuint old[2] = { m_textures[0], m_textures[1] };
+    GLenum status = GL_FRAMEBUFFER_COMPLETE;
+    glActiveTexture(GL_TEXTURE0 + m_unit);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < 2; ++i) {
+        glGenTextures(1, &m_textures[i]);
+        glBindTexture(GL_TEXTURE_2D, m_textures[i]);
+        // Linear, so shaders can sample the state between texels (advection)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_textures[i], 0);
+        if (status == GL_FRAMEBUFFER_COMPLETE) status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    if (status == GL_FRAMEBUFFER_COMPLETE && old[m_previous]) {
+        // Stretched into the new size: a render scale change must not wipe out the effect
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_copyFramebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, old[m_previous], 0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffers[m_previous]);
+        glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteTextures(2, old);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "[Feedback] Framebuffer incomplete (0x" << std::hex << status << std::dec
+                  << "), shaders run without their previous frame" << std::endl;
+        glDeleteTextures(2, m_textures);
+        glDeleteFramebuffers(2, m_framebuffers);
+        glDeleteFramebuffers(1, &m_copyFramebuffer);
+        m_textures[0] = m_textures[1] = 0;
+        m_width = m_height = 0;
+        glActiveTexture(GL_TEXTURE0);
+        return false;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_textures[m_previous]);
+    glActiveTexture(GL_TEXTURE0);
+    m_width = width;
+    m_height = height;
+    return true;
+}
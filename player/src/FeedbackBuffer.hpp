@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+
+/**
+ * FeedbackBuffer - Previous frame of a stateful shader, ping-ponged between two textures
+ *
+ * A shader that declares '#pragma feedback' reads what it drew last frame
+ * through u_prevFrame and draws its next state into the other texture; the
+ * two trade places every frame, nothing is copied. Effects like trails or
+ * advected dye then update incrementally instead of rebuilding their whole
+ * state from u_time on every pixel.
+ *
+ * The state is RGBA8 at the shader's render size. A resize (window or
+ * render scale) stretches the old state into the new textures instead of
+ * dropping it; clear() resets it to transparent black, e.g. when another
+ * shader takes over.
+ *
+ * Render thread only; needs framebuffer objects and framebuffer blits.
+ */
+class FeedbackBuffer {
+public:
+    // The previous frame stays bound on texture unit 'unit'
+    explicit FeedbackBuffer(GLuint unit);
+
+    bool create();
+    // Binds the framebuffer of the next state for a frame of width x height;
+    // false (feedback unusable from then on) if the framebuffer is incomplete
+    bool begin(int width, int height);
+    // The state just drawn becomes the previous frame, bound on the unit
+    void end();
+    void clear();
+
+private:
+    bool resize(int width, int height);
+
+    GLuint m_unit;
+    GLuint m_textures[2] = { 0, 0 };
+    GLuint m_framebuffers[2] = { 0, 0 };   // m_framebuffers[i] draws into m_textures[i]
+    GLuint m_copyFramebuffer = 0;          // Reads the old state while resizing
+    int m_previous = 0;                    // Index of the previous frame
+    int m_width = 0, m_height = 0;
+};
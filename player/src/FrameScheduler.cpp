@@ -0,0 +1,68 @@
+#include "FrameScheduler.hpp"
+#include <algorithm>
+#include <thread>
+
+static FrameScheduler::Clock::duration interval(float fps) {
+    return std::chrono::duration_cast<FrameScheduler::Clock::duration>(std::chrono::duration<float>(1.0f / fps));
+}
+
+void FrameScheduler::setTargetFps(float fps) {
+    m_targetFps = std::clamp(fps, MIN_FPS, MAX_FPS);
+}
+
+void FrameScheduler::setIdleFps(float fps) {
+    m_idleFps = std::clamp(fps, MIN_FPS, MAX_FPS);
+}
+
+void FrameScheduler::update(bool playing, float rms) {
+    Clock::time_point now = Clock::now();
+    if (!m_started) {
+        m_started = true;
+        m_due = now;
+    }
+    // The silence timer starts over with every start or resume
+    if ((playing && !m_wasPlaying) || (playing && rms >= SILENT_RMS)) m_lastAudible = now;
+    m_wasPlaying = playing;
+    m_idle = !playing || std::chrono::duration<float>(now - m_lastAudible).count() > SILENCE_SECONDS;
+}
+
+void FrameScheduler::wait(const std::function<bool(float& rms)>& probe) {
+    Clock::time_point now = Clock::now();
+    if (!m_started) {
+        m_started = true;
+        m_due = now;
+    }
+    float target = m_targetFps;
+    bool idle = m_idle;
+    Clock::duration period = interval(idle ? std::min<float>(m_idleFps, target) : target);
+    Clock::time_point next = m_due + period;
+
+    if (now >= next) {
+        if (!idle && now - next > period / 2) m_lateFrames++;
+        m_due = now;
+        return;
+    }
+    // The swap already waited for the refresh, which comes no faster than the target
+    if (!idle && m_vsyncHz > 0 && m_vsyncHz <= target + 1.0f) {
+        m_due = now;
+        return;
+    }
+
+    m_due = next;
+    Clock::time_point wakeAt = next - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(SLACK_MS));
+    if (!idle) {
+        std::this_thread::sleep_until(wakeAt);
+        return;
+    }
+    Clock::duration slice = interval(target);
+    while ((now = Clock::now()) < wakeAt) {
+        std::this_thread::sleep_until(std::min(wakeAt, now + slice));
+        float rms = 0.0f;
+        bool playing = probe(rms);
+        update(playing, rms);
+        if (!m_idle) {
+            m_due = Clock::now();
+            return;
+        }
+    }
+}
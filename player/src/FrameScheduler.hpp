@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+/**
+ * FrameScheduler - Paces the render loop at a target or idle frame rate
+ *
+ * Frames are due every 1/fps seconds, counted from the previous due time so
+ * the rate does not drift with the frame cost; a frame that ends past its
+ * successor's due time restarts the schedule instead of bursting to catch up.
+ * The wait stops SLACK_MS short of the due time and leaves the rest to the
+ * buffer swap. When vsync runs at or below the target rate the swap alone
+ * paces the loop and nothing is slept: sleeping on top of a vsync wait
+ * misses every other refresh.
+ *
+ * The idle rate applies while nothing is playing, or once the signal stayed
+ * below SILENT_RMS for SILENCE_SECONDS. The idle wait is cut into target
+ * rate slices that probe the player, so resuming costs at most one frame.
+ *
+ * Rates may be set from any thread, the rest is render thread only.
+ */
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr float MIN_FPS = 1.0f;
+    static constexpr float MAX_FPS = 240.0f;
+    static constexpr float SILENT_RMS = 0.001f;      // About -60 dBFS
+    static constexpr float SILENCE_SECONDS = 2.0f;
+    static constexpr float SLACK_MS = 2.0f;
+
+    // Clamped to MIN_FPS..MAX_FPS; the idle rate never exceeds the target
+    void setTargetFps(float fps);
+    float getTargetFps() const { return m_targetFps; }
+    void setIdleFps(float fps);
+    float getIdleFps() const { return m_idleFps; }
+    bool isIdle() const { return m_idle; }
+    // Refresh rate the swap waits for, 0 = no vsync (or unknown rate)
+    void setVsyncHz(int hz) { m_vsyncHz = hz; }
+    // Frames that ended more than half an interval after the next was due, at the target rate
+    uint64_t getLateFrames() const { return m_lateFrames; }
+
+    // Once per frame: switches between the target and the idle rate
+    void update(bool playing, float rms);
+
+    // After the swap, until the next frame is due. While idle, 'probe' is
+    // asked every target interval for the playback state (returns playing,
+    // fills rms) and a resume ends the wait at once.
+    void wait(const std::function<bool(float& rms)>& probe);
+
+private:
+    std::atomic<float> m_targetFps{60.0f};
+    std::atomic<float> m_idleFps{10.0f};
+    std::atomic<bool> m_idle{false};
+    std::atomic<uint64_t> m_lateFrames{0};
+    Clock::time_point m_due;             // Start of the current frame, as scheduled
+    Clock::time_point m_lastAudible;
+    int m_vsyncHz = 0;
+    bool m_started = false;
+    bool m_wasPlaying = false;
+};
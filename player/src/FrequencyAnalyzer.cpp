@@ -1,123 +1,462 @@
 #include "FrequencyAnalyzer.hpp"
+#include "Realtime.hpp"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <time.h>
 
-const float PI = 3.141592653589793238460;
+static int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-FrequencyAnalyzer::FrequencyAnalyzer() {
-    m_inputBuffer.reserve(FFT_SIZE);
+static uint64_t threadCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 }
 
-void FrequencyAnalyzer::pushSamples(const float* mySamples, int count) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+// Linear resampling of a band snapshot to another band count
+static void stretchBands(const float* in, int inCount, float* out, int outCount) {
+    if (inCount <= 0) {
+        std::fill(out, out + outCount, 0.0f);
+        return;
+    }
+    if (inCount == outCount) {
+        std::copy(in, in + inCount, out);
+        return;
+    }
+    for (int i = 0; i < outCount; ++i) {
+        float x = (i + 0.5f) * inCount / outCount - 0.5f;
+        int i0 = std::max(0, std::min(inCount - 1, (int)std::floor(x)));
+        int i1 = std::min(inCount - 1, i0 + 1);
+        float frac = std::max(0.0f, std::min(1.0f, x - i0));
+        out[i] = in[i0] + (in[i1] - in[i0]) * frac;
+    }
+}
+
+FrequencyAnalyzer::FrequencyAnalyzer() {}
+
+FrequencyAnalyzer::~FrequencyAnalyzer() {
+    m_active = false;
+    m_stopThread = true;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void FrequencyAnalyzer::acquire() {
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    if (m_consumers++ > 0) return;
     
-    // Add new samples to buffer
-    for (int i = 0; i < count; ++i) {
-        if (m_inputBuffer.size() >= FFT_SIZE) {
-            m_inputBuffer.erase(m_inputBuffer.begin());
+    m_stopThread = false;
+    m_thread = std::thread(&FrequencyAnalyzer::analysisLoop, this);
+    m_active = true;
+}
+
+void FrequencyAnalyzer::release() {
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    if (m_consumers == 0 || --m_consumers > 0) return;
+    
+    m_active = false;
+    m_stopThread = true;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool FrequencyAnalyzer::setFftSize(int size) {
+    if (!RealFft::isValidSize(size)) return false;
+    m_fftSize = size;
+    return true;
+}
+
+void FrequencyAnalyzer::setTrackAnalysis(std::shared_ptr<const TrackAnalysis> analysis) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_trackAnalysis = analysis;
+    m_replaying = (analysis != nullptr);
+    m_position = 0.0;
+}
+
+void FrequencyAnalyzer::setPlaybackPosition(double seconds) {
+    // Not atomic as a whole; a reader mixing two blocks is off by one block at most
+    m_position = seconds;
+    m_clockFrames.store(m_streamFrames.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_clockNs.store(monotonicNs(), std::memory_order_release);
+}
+
+bool FrequencyAnalyzer::setDelayMs(float ms) {
+    if (ms < -500.0f || ms > 2000.0f) return false;
+    m_delayMs = ms;
+    return true;
+}
+
+double FrequencyAnalyzer::getOutputDelay() const {
+    int64_t clockNs = m_clockNs.load(std::memory_order_acquire);
+    if (clockNs == 0) return 0.0;
+    double delay = m_outputLatency / (double)m_sampleRate + m_delayMs / 1000.0;
+    double elapsed = (monotonicNs() - clockNs) / 1e9;
+    // Once the device has drained (or we paused) the last rendered sample is the one heard
+    return std::max(0.0, delay - elapsed);
+}
+
+void FrequencyAnalyzer::configure(float sampleRate, int channels) {
+    if (sampleRate > 0.0f) m_sampleRate = sampleRate;
+    if (channels > 0) m_channels = channels;
+}
+
+bool FrequencyAnalyzer::setHopSize(int frames) {
+    if (frames < 32 || frames > RealFft::MAX_SIZE) return false;
+    m_hopSize = frames;
+    return true;
+}
+
+bool FrequencyAnalyzer::setOverlap(float overlap) {
+    if (overlap < 0.0f || overlap > 0.95f) return false;
+    return setHopSize(std::max(32, (int)(m_fftSize * (1.0f - overlap) + 0.5f)));
+}
+
+void FrequencyAnalyzer::setLayout(BandMapper::Layout layout) {
+    m_layout = (int)layout;
+}
+
+bool FrequencyAnalyzer::setSpectrumBands(int bands) {
+    if (bands < 1 || bands > MAX_BANDS) return false;
+    m_spectrumBands = bands;
+    return true;
+}
+
+std::string FrequencyAnalyzer::describe() {
+    int fftSize = m_fftSize, hop = m_hopSize;
+    float rate = m_sampleRate;
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_trackAnalysis) {
+            ss << "Analyzer: output delay " << 1000.0 * (m_outputLatency / (double)rate) + m_delayMs
+               << " ms, replaying precomputed analysis, " << m_trackAnalysis->describe()
+               << ", " << (m_active ? "running" : "idle");
+            return ss.str();
         }
-        m_inputBuffer.push_back(mySamples[i]);
     }
+    ss << "Analyzer: output delay " << 1000.0 * (m_outputLatency / (double)rate) + m_delayMs << " ms, fft " << fftSize << " (" << rate / fftSize << " Hz/bin), hop " << hop;
+    if (hop < fftSize) ss << " (" << 100.0f * (fftSize - hop) / fftSize << "% overlap";
+    else ss << " (no overlap";
+    ss << ", " << rate / hop << " spectra/s), layout " << BandMapper::layoutName(getLayout())
+       << ", " << (m_active ? "running" : "idle") << ", " << m_statSpectra << " spectra";
+    AudioFeatures features = getFeatures();
+    if (features.bpm > 0.0f) {
+        ss << ", tempo " << features.bpm << " BPM (confidence " << std::setprecision(2) << features.beatConfidence << ")";
+    }
+    return ss.str();
+}
+
+FrequencyAnalyzer::Stats FrequencyAnalyzer::getStats() const {
+    Stats stats;
+    stats.spectra = m_statSpectra;
+    stats.analysisNs = m_statNs;
+    stats.droppedSamples = m_tap.dropped();
+    stats.skippedSamples = m_statSkipped;
+    return stats;
+}
+
+// Interleaved -> left/right pairs in small stack blocks, then into the tap.
+// Mono is duplicated; with more channels only the front pair is used.
+template <typename T>
+static size_t pushPairs(SampleTap& tap, const T* samples, int count, int channels, float scale) {
+    float block[512];
+    int frames = count / channels;
+    int right = (channels > 1) ? 1 : 0;
+    size_t pushed = 0;
+    while (frames > 0) {
+        int n = (frames < 256) ? frames : 256;
+        for (int i = 0; i < n; ++i) {
+            block[2 * i] = samples[0] * scale;
+            block[2 * i + 1] = samples[right] * scale;
+            samples += channels;
+        }
+        pushed += tap.push(block, 2 * n);
+        frames -= n;
+    }
+    return pushed / 2;
+}
+
+void FrequencyAnalyzer::pushSamples(const float* mySamples, int count) {
+    if (!m_active) return;
+    int channels = m_channels;
+    size_t pushed = (channels == 2) ? m_tap.push(mySamples, count) / 2
+                                    : pushPairs(m_tap, mySamples, count, channels, 1.0f);
+    m_streamFrames.store(m_streamFrames.load(std::memory_order_relaxed) + pushed, std::memory_order_relaxed);
+}
+
+void FrequencyAnalyzer::pushSamples(const int16_t* samples, int count) {
+    if (!m_active) return;
+    size_t pushed = pushPairs(m_tap, samples, count, m_channels, 1.0f / 32768.0f);
+    m_streamFrames.store(m_streamFrames.load(std::memory_order_relaxed) + pushed, std::memory_order_relaxed);
+}
+
+// Box-filtered decimation of one channel of the analysis window
+static void decimate(const float* in, int count, float* out, int points) {
+    for (int p = 0; p < points; ++p) {
+        int begin = (int)((int64_t)p * count / points);
+        int end = std::max(begin + 1, (int)((int64_t)(p + 1) * count / points));
+        float sum = 0.0f;
+        for (int i = begin; i < end; ++i) sum += in[i];
+        out[p] = sum / (end - begin);
+    }
+}
+
+// Bins -> published bands; fixed-count layouts (1/3 octave) are widened as bars
+static void mapBands(BandMapper& mapper, const float* bins, std::vector<float>& mapped, float* out, int bands) {
+    mapper.map(bins, mapped.data());
+    int count = mapper.bands();
+    if (count == bands) {
+        std::copy(mapped.begin(), mapped.begin() + bands, out);
+        return;
+    }
+    for (int i = 0; i < bands; ++i) {
+        out[i] = count > 0 ? mapped[(size_t)i * count / bands] : 0.0f;
+    }
+}
+
+void FrequencyAnalyzer::analysisLoop() {
+    Realtime::applyToCurrentThread(Realtime::Role::Analysis);
+    
+    int fftSize = 0;
+    int hopSize = 0;
+    float sampleRate = 0.0f;
+    RealFft fft;
+    FeatureExtractor extractor;
+    AudioFeatures features;
+    std::vector<float> left, right, mid, side, pairs;
+    std::vector<float> midRe, midIm, sideRe, sideIm;
+    std::vector<float> magnitudes[3];     // Mix, left, right
+    BandMapper mapper;                    // Rebuilt only when layout/size/rate change
+    std::vector<float> mapped;
+    std::vector<float> spectra(3 * MAX_BANDS, 0.0f), waveform(2 * WAVEFORM_POINTS, 0.0f);
     
-    // Only compute if we have enough data
-    if (m_inputBuffer.size() == FFT_SIZE) {
-        // Prepare complex buffer for FFT
-        std::vector<std::complex<float>> data(FFT_SIZE);
+    // Whatever was queued before the last release is stale
+    m_tapFrames += m_tap.skip(m_tap.available()) / 2;
+    
+    while (!m_stopThread) {
+        // Pick up configuration changes between spectra
+        if (fftSize != m_fftSize || hopSize != m_hopSize || sampleRate != m_sampleRate) {
+            fftSize = m_fftSize;
+            hopSize = m_hopSize;
+            sampleRate = m_sampleRate;
+            fft = RealFft(fftSize);
+            extractor.reset(fftSize, hopSize, sampleRate);
+            for (std::vector<float>* window : { &left, &right, &mid, &side }) window->assign(fftSize, 0.0f);
+            pairs.assign(2 * std::min(hopSize, fftSize), 0.0f);
+            for (std::vector<float>* bins : { &midRe, &midIm, &sideRe, &sideIm }) bins->assign(fftSize / 2 + 1, 0.0f);
+            for (std::vector<float>& bins : magnitudes) bins.assign(fftSize / 2, 0.0f);
+        }
         
-        // Apply Hanning window to reduce spectral leakage
-        for (int i = 0; i < FFT_SIZE; ++i) {
-            float window = 0.5f * (1.0f - cos(2.0f * PI * i / (FFT_SIZE - 1)));
-            data[i] = std::complex<float>(m_inputBuffer[i] * window, 0.0f);
+        size_t available = m_tap.available() / 2;
+        if (available < (size_t)hopSize) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            continue;
         }
         
-        // Perform FFT
-        fft(data);
+        uint64_t cpu0 = threadCpuNs();
         
-        // Compute magnitudes (only first half is useful for real input)
-        std::vector<float> magnitudes;
-        magnitudes.resize(FFT_SIZE / 2);
+        // More than one spectrum behind: only the newest one matters
+        size_t keep = (size_t)std::max(fftSize, hopSize);
+        if (available >= keep + hopSize) {
+            size_t excess = (available - keep) / hopSize * hopSize;
+            size_t skipped = m_tap.skip(2 * excess) / 2;
+            m_statSkipped += skipped;
+            m_tapFrames += skipped;
+        }
         
-        float maxVal = 0.0001f; // Prevent div by zero
-        for (int i = 0; i < FFT_SIZE / 2; ++i) {
-            float mag = std::abs(data[i]);
-            magnitudes[i] = mag;
-            if (mag > maxVal) maxVal = mag;
+        int fresh = std::min(hopSize, fftSize);
+        if (hopSize < fftSize) {
+            // Overlapping windows: slide by one hop and append the new samples
+            std::memmove(left.data(), left.data() + hopSize, (fftSize - hopSize) * sizeof(float));
+            std::memmove(right.data(), right.data() + hopSize, (fftSize - hopSize) * sizeof(float));
+        } else {
+            // Hop longer than the window: only the last fftSize samples of the hop are used
+            m_tapFrames += m_tap.skip(2 * (hopSize - fftSize)) / 2;
         }
+        m_tapFrames += m_tap.pop(pairs.data(), 2 * fresh) / 2;
+        for (int i = 0; i < fresh; ++i) {
+            left[fftSize - fresh + i] = pairs[2 * i];
+            right[fftSize - fresh + i] = pairs[2 * i + 1];
+        }
+        // Stamped with the window centre
+        uint64_t stamp = m_tapFrames > (uint64_t)fftSize / 2 ? m_tapFrames - fftSize / 2 : 0;
+        
+        decimate(left.data(), fftSize, waveform.data(), WAVEFORM_POINTS);
+        decimate(right.data(), fftSize, waveform.data() + WAVEFORM_POINTS, WAVEFORM_POINTS);
         
-        // Normalize
-        for (float& val : magnitudes) {
-            val /= maxVal;
+        int bands = m_spectrumBands;
+        if (!(m_replaying && replayFrame(stamp, bands, spectra.data(), features))) {
+            bool stereo = m_channels > 1;
+            for (int i = 0; i < fftSize; ++i) {
+                mid[i] = 0.5f * (left[i] + right[i]);
+                side[i] = 0.5f * (left[i] - right[i]);
+            }
+            
+            // Mix = |M|; channels from the complex mid and side spectra: L = M + S, R = M - S
+            const int bins = fftSize / 2;
+            fft.forward(mid.data(), midRe.data(), midIm.data());
+            for (int k = 0; k < bins; ++k) magnitudes[0][k] = std::sqrt(midRe[k] * midRe[k] + midIm[k] * midIm[k]);
+            if (stereo) {
+                fft.forward(side.data(), sideRe.data(), sideIm.data());
+                for (int k = 0; k < bins; ++k) {
+                    float lr = midRe[k] + sideRe[k], li = midIm[k] + sideIm[k];
+                    float rr = midRe[k] - sideRe[k], ri = midIm[k] - sideIm[k];
+                    magnitudes[1][k] = std::sqrt(lr * lr + li * li);
+                    magnitudes[2][k] = std::sqrt(rr * rr + ri * ri);
+                }
+            } else {
+                magnitudes[1] = magnitudes[0];
+                magnitudes[2] = magnitudes[0];
+            }
+            
+            // Features need absolute levels, so they run before normalization
+            extractor.process(mid.data() + fftSize - fresh, fresh, magnitudes[0].data(), features);
+            
+            // Normalize: the mix on its own, the channels on a shared scale
+            float maxMix = 0.0001f, maxChannel = 0.0001f; // Prevent div by zero
+            for (int k = 0; k < bins; ++k) {
+                maxMix = std::max(maxMix, magnitudes[0][k]);
+                maxChannel = std::max(maxChannel, std::max(magnitudes[1][k], magnitudes[2][k]));
+            }
+            for (int k = 0; k < bins; ++k) {
+                magnitudes[0][k] /= maxMix;
+                magnitudes[1][k] /= maxChannel;
+                magnitudes[2][k] /= maxChannel;
+            }
+            
+            BandMapper::Layout layout = getLayout();
+            if (!mapper.matches(layout, bands, fftSize, sampleRate)) {
+                mapper.build(layout, bands, fftSize, sampleRate);
+                mapped.assign(mapper.bands(), 0.0f);
+            }
+            for (int c = 0; c < 3; ++c) {
+                mapBands(mapper, magnitudes[c].data(), mapped, spectra.data() + c * bands, bands);
+            }
         }
+        FeatureExtractor::processStereo(left.data(), right.data(), fftSize, features);
         
-        m_currentSpectrum = magnitudes;
+        publish(spectra.data(), bands, waveform.data(), features, stamp);
+        m_statSpectra++;
+        m_statNs += threadCpuNs() - cpu0;
     }
 }
 
-std::vector<float> FrequencyAnalyzer::getSpectrum(int bands) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (m_currentSpectrum.empty()) return std::vector<float>(bands, 0.0f);
+bool FrequencyAnalyzer::replayFrame(uint64_t stamp, int bands, float* spectra, AudioFeatures& features) {
+    std::shared_ptr<const TrackAnalysis> analysis;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        analysis = m_trackAnalysis;
+    }
+    if (!analysis) return false;
     
-    std::vector<float> result(bands, 0.0f);
+    // Source position of the window centre, counted back from the last rendered block
+    uint64_t clock = m_clockFrames.load(std::memory_order_relaxed);
+    double behind = clock > stamp ? (clock - stamp) / (double)m_sampleRate : 0.0;
+    double position = std::max(0.0, m_position - behind);
     
-    // Map FFT bins to requested bands
-    // This is a simple linear interpolation, can be improved to logarithmic later
-    int binsPerBand = m_currentSpectrum.size() / bands;
-    if (binsPerBand < 1) binsPerBand = 1;
+    float stored[TrackAnalysis::BANDS];
+    analysis->spectrumAt(position, stored);
+    stretchBands(stored, TrackAnalysis::BANDS, spectra, bands);
+    // Stored frames are mono: both channels show the mix
+    std::copy(spectra, spectra + bands, spectra + bands);
+    std::copy(spectra, spectra + bands, spectra + 2 * bands);
+    features = analysis->featuresAt(position);
+    return true;
+}
 
-    for (int i = 0; i < bands; ++i) {
-        float sum = 0;
-        int count = 0;
-        int startBin = i * binsPerBand;
-        for (int j = 0; j < binsPerBand && (startBin + j) < m_currentSpectrum.size(); ++j) {
-            sum += m_currentSpectrum[startBin + j];
-            count++;
-        }
-        result[i] = (count > 0) ? (sum / count) : 0.0f;
-    }
-    
-    return result;
+void FrequencyAnalyzer::publish(const float* spectra, int bands, const float* waveform, const AudioFeatures& features, uint64_t stamp) {
+    static_assert(sizeof(AudioFeatures) == AudioFeatures::FLOAT_COUNT * sizeof(float), "AudioFeatures must be plain floats");
+    uint64_t frame = m_published.load(std::memory_order_relaxed) + 1;
+    size_t slot = (frame - 1) % HISTORY_FRAMES;
+    m_spectrum[slot].write(spectra, 3 * bands, stamp);
+    m_waveform[slot].write(waveform, 2 * WAVEFORM_POINTS, stamp);
+    m_features[slot].write(reinterpret_cast<const float*>(&features), AudioFeatures::FLOAT_COUNT, stamp);
+    m_published.store(frame, std::memory_order_release);
 }
 
-float FrequencyAnalyzer::getDominantFrequency(float sampleRate) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+uint64_t FrequencyAnalyzer::pickFrame(uint64_t& stamp) const {
+    uint64_t newest = m_published.load(std::memory_order_acquire);
+    if (newest == 0) return 0;
+    uint64_t oldest = newest > (uint64_t)HISTORY_FRAMES - 1 ? newest - (HISTORY_FRAMES - 1) : 1;
     
-    if (m_currentSpectrum.empty()) return 0.0f;
+    double behind = getOutputDelay() * m_sampleRate;
+    uint64_t clock = m_clockFrames.load(std::memory_order_relaxed);
+    uint64_t heard = clock > (uint64_t)behind ? clock - (uint64_t)behind : 0;
     
-    float maxMag = -1.0f;
-    int maxBin = -1;
-    
-    // Find bin with max magnitude
-    for (size_t i = 1; i < m_currentSpectrum.size(); ++i) { // Skip DC component at i=0
-        if (m_currentSpectrum[i] > maxMag) {
-            maxMag = m_currentSpectrum[i];
-            maxBin = i;
-        }
+    // Newest frame centred at or before the heard sample; the oldest if even that is ahead
+    for (uint64_t frame = newest; frame >= oldest; --frame) {
+        stamp = m_spectrum[(frame - 1) % HISTORY_FRAMES].stamp();
+        if (stamp <= heard || frame == oldest) return frame;
     }
-    
-    if (maxBin <= 0) return 0.0f;
-    
-    // Frequency = binIndex * SampleRate / FFT_SIZE
-    return (float)maxBin * sampleRate / FFT_SIZE;
+    return 0;
 }
 
-// Simple recursive Cooley-Tukey FFT
-void FrequencyAnalyzer::fft(std::vector<std::complex<float>>& x) {
-    int n = x.size();
-    if (n <= 1) return;
-    
-    std::vector<std::complex<float>> even(n / 2), odd(n / 2);
-    for (int i = 0; i < n / 2; ++i) {
-        even[i] = x[2 * i];
-        odd[i] = x[2 * i + 1];
+template <size_t N>
+bool FrequencyAnalyzer::readFrame(const SeqlockBuffer<N>* ring, float* out, size_t& count, uint64_t& generation) const {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        uint64_t stamp = 0;
+        uint64_t frame = pickFrame(stamp);
+        if (frame == 0 || frame == generation) return false;
+        
+        uint64_t slotGeneration = ~0ull, stored = 0;
+        ring[(frame - 1) % HISTORY_FRAMES].read(out, N, count, slotGeneration, &stored);
+        // Overwritten by a newer frame since it was picked: pick again
+        if (stored != stamp) continue;
+        generation = frame;
+        return true;
     }
+    return false;
+}
+
+bool FrequencyAnalyzer::readFeatures(AudioFeatures& out, uint64_t& generation) const {
+    float values[AudioFeatures::FLOAT_COUNT];
+    size_t count = 0;
+    if (!readFrame(m_features, values, count, generation)) return false;
+    std::copy(values, values + AudioFeatures::FLOAT_COUNT, reinterpret_cast<float*>(&out));
+    return true;
+}
+
+AudioFeatures FrequencyAnalyzer::getFeatures() const {
+    AudioFeatures features;
+    uint64_t generation = ~0ull;
+    readFeatures(features, generation);
+    return features;
+}
+
+bool FrequencyAnalyzer::readSpectrum(float* out, int bands, uint64_t& generation, Channel channel) const {
+    if (bands <= 0) return false;
+    if (bands > MAX_BANDS) bands = MAX_BANDS;
     
-    fft(even);
-    fft(odd);
-    
-    for (int k = 0; k < n / 2; ++k) {
-        std::complex<float> t = std::polar(1.0f, -2.0f * PI * k / n) * odd[k];
-        x[k] = even[k] + t;
-        x[k + n / 2] = even[k] - t;
-    }
+    float snapshot[3 * MAX_BANDS];
+    size_t count = 0;
+    if (!readFrame(m_spectrum, snapshot, count, generation)) return false;
+    int rows = (int)count / 3;
+    stretchBands(snapshot + (int)channel * rows, rows, out, bands);
+    return true;
+}
+
+bool FrequencyAnalyzer::readWaveform(float* out, uint64_t& generation) const {
+    float snapshot[2 * WAVEFORM_POINTS];
+    size_t count = 0;
+    if (!readFrame(m_waveform, snapshot, count, generation)) return false;
+    std::copy(snapshot, snapshot + 2 * WAVEFORM_POINTS, out);
+    return true;
+}
+
+std::vector<float> FrequencyAnalyzer::getSpectrum(int bands) {
+    std::vector<float> result(std::max(bands, 0), 0.0f);
+    uint64_t generation = ~0ull;
+    readSpectrum(result.data(), bands, generation);
+    return result;
+}
+
+float FrequencyAnalyzer::getDominantFrequency(float sampleRate) {
+    AudioFeatures features = getFeatures();
+    if (sampleRate <= 0.0f || features.sampleRate <= 0.0f) return features.dominantHz;
+    return features.dominantHz * sampleRate / features.sampleRate;
 }
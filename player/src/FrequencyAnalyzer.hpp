@@ -1,28 +1,173 @@
 #pragma once
 #include <vector>
-#include <complex>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include "RealFft.hpp"
+#include "SampleTap.hpp"
+#include "BandMapper.hpp"
+#include "FeatureExtractor.hpp"
+#include "TrackAnalysis.hpp"
+#include "SeqlockBuffer.hpp"
+#include <string>
+#include <algorithm>
 
+/**
+ * FrequencyAnalyzer - Spectrum of the playing audio
+ *
+ * The audio thread only copies samples (as left/right pairs) into a
+ * lock-free SampleTap. A separate analysis thread runs the FFT every
+ * hop-size frames over the last FFT-size frames and publishes the result:
+ * the spectrum of the mix and of each channel (from one mid and one side
+ * transform), a decimated waveform of both channels and stereo features.
+ * The thread (and the tap) only run while at least one consumer holds
+ * acquire(), e.g. the visualizer. Bins are grouped into display bands by a
+ * BandMapper table on the analysis thread, once per hop.
+ *
+ * The band snapshot and an AudioFeatures vector (levels, flux, onset,
+ * tempo) are published through seqlocks: readers copy into their own
+ * storage without locking or allocating, and a generation counter lets
+ * them skip frames that did not change.
+ *
+ * Samples reach the tap when the device asks for them, which is ahead of
+ * what is heard by the output latency. Published frames are therefore
+ * stamped with the stream position of their window centre and kept for
+ * HISTORY_FRAMES hops; readers get the frame playing at the speaker, using
+ * the device latency reported by the mixer and the time of the last render.
+ *
+ * When the track carries a precomputed TrackAnalysis the FFT stays off:
+ * spectra and spectral features come from the stored frames, only the
+ * waveform and stereo features are still taken from the tap.
+ */
 class FrequencyAnalyzer {
 public:
     FrequencyAnalyzer();
+    ~FrequencyAnalyzer();
     
-    // Updates the analyzer with new PCM samples
+    // Stream layout of the pushed samples; call before playback starts
+    void configure(float sampleRate, int channels);
+    
+    // Audio thread: interleaved samples, never blocks, no-op while nobody is subscribed
     void pushSamples(const float* mySamples, int count);
+    void pushSamples(const int16_t* samples, int count);
+    
+    // Precomputed analysis of the current track (nullptr = analyse live)
+    void setTrackAnalysis(std::shared_ptr<const TrackAnalysis> analysis);
+    bool hasTrackAnalysis() const { return m_replaying; }
+    // Audio thread, after each rendered block: source position at its end (seconds)
+    void setPlaybackPosition(double seconds);
+    
+    // Frames (at the configured rate) between rendering and the speaker, from the mixer
+    void setOutputLatency(int frames) { m_outputLatency = std::max(0, frames); }
+    // Manual trim on top, for outputs that under-report (Bluetooth), -500..2000 ms
+    bool setDelayMs(float ms);
+    float getDelayMs() const { return m_delayMs; }
+    // How long the last rendered sample still takes to be heard, seconds
+    double getOutputDelay() const;
+    
+    // Consumers: analysis runs while the count is non-zero
+    void acquire();
+    void release();
+    bool isActive() const { return m_active; }
+    
+    // Resolution of the published band snapshot, 1..MAX_BANDS (default 256)
+    static const int MAX_BANDS = 512;
+    // Waveform points per channel, spanning the last FFT-size frames
+    static const int WAVEFORM_POINTS = 512;
+    // Published hops kept for latency alignment (~0.7 s at the default hop)
+    static const int HISTORY_FRAMES = 64;
+    bool setSpectrumBands(int bands);
+    int getSpectrumBands() const { return m_spectrumBands; }
+    
+    enum class Channel { Mix, Left, Right };
     
-    // Retrieves the current frequency spectrum (normalized 0.0 - 1.0)
-    // bands: number of output bands desired
-    // bands: number of output bands desired
+    // Copies the spectrum being heard (normalized 0.0 - 1.0) into out[bands] if
+    // its generation differs from 'generation', which is then updated. Lock- and
+    // allocation-free; other band counts are resampled from the snapshot.
+    // Channel spectra share one scale so their levels can be compared.
+    bool readSpectrum(float* out, int bands, uint64_t& generation, Channel channel = Channel::Mix) const;
+    
+    // Left then right, WAVEFORM_POINTS each (-1..1, oldest first); same generations as above
+    bool readWaveform(float* out, uint64_t& generation) const;
+    
+    // Allocating convenience wrapper around readSpectrum()
     std::vector<float> getSpectrum(int bands);
     
-    // Returns the frequency (Hz) with the highest magnitude
-    float getDominantFrequency(float sampleRate);
+    // Returns the frequency (Hz) with the highest magnitude (0 = configured rate)
+    float getDominantFrequency(float sampleRate = 0.0f);
+    
+    // Feature vector being heard; lock-free, all zero until the first hop
+    AudioFeatures getFeatures() const;
+    bool readFeatures(AudioFeatures& out, uint64_t& generation) const;
 
-private:
-    void fft(std::vector<std::complex<float>>& x);
+    // Power of two in [RealFft::MIN_SIZE, RealFft::MAX_SIZE]
+    bool setFftSize(int size);
+    int getFftSize() const { return m_fftSize; }
+    
+    // Frames between two spectra; setOverlap() derives it from the FFT size
+    bool setHopSize(int frames);
+    bool setOverlap(float overlap);
+    int getHopSize() const { return m_hopSize; }
     
+    void setLayout(BandMapper::Layout layout);
+    BandMapper::Layout getLayout() const { return (BandMapper::Layout)m_layout.load(); }
+    
+    std::string describe();
+
+    struct Stats {
+        uint64_t spectra = 0;
+        uint64_t analysisNs = 0;     // Analysis thread CPU time
+        uint64_t droppedSamples = 0; // Tap overflow (analysis fell behind)
+        uint64_t skippedSamples = 0; // Backlog discarded to stay current
+    };
+    Stats getStats() const;
+
+private:
+    void analysisLoop();
+    // Replay: bands and spectral features of the stored frame at the source position of 'stamp'
+    bool replayFrame(uint64_t stamp, int bands, float* spectra, AudioFeatures& features);
+    // spectra: mix, left and right rows of 'bands' values
+    void publish(const float* spectra, int bands, const float* waveform, const AudioFeatures& features, uint64_t stamp);
+    // Frame (1-based publish count) matching the audible position, 0 = none yet
+    uint64_t pickFrame(uint64_t& stamp) const;
+    template <size_t N>
+    bool readFrame(const SeqlockBuffer<N>* ring, float* out, size_t& count, uint64_t& generation) const;
+
+    // Published results, a ring indexed by frame; the analysis thread is the only writer
+    SeqlockBuffer<3 * MAX_BANDS> m_spectrum[HISTORY_FRAMES];
+    SeqlockBuffer<2 * WAVEFORM_POINTS> m_waveform[HISTORY_FRAMES];
+    SeqlockBuffer<AudioFeatures::FLOAT_COUNT> m_features[HISTORY_FRAMES];
+    std::atomic<uint64_t> m_published{0};
+    uint64_t m_tapFrames = 0;              // Analysis thread: tap frames consumed so far
+
+    // Output clock, written by the audio thread after each block
+    std::atomic<uint64_t> m_streamFrames{0};   // Frames (left/right pairs) pushed into the tap
+    std::atomic<uint64_t> m_clockFrames{0};    // m_streamFrames at the last block
+    std::atomic<int64_t> m_clockNs{0};         // When the last block was rendered
+    std::atomic<int> m_outputLatency{0};
+    std::atomic<float> m_delayMs{0.0f};
+
+    // Shared configuration, applied by the analysis thread
+    std::atomic<int> m_layout{(int)BandMapper::Layout::Log};
+    std::atomic<int> m_spectrumBands{256};
+    std::atomic<int> m_fftSize{2048};
+    std::atomic<int> m_hopSize{512};
+    std::atomic<float> m_sampleRate{48000.0f};
+    std::atomic<int> m_channels{2};
+
+    // Replay of a precomputed analysis
     std::mutex m_mutex;
-    std::vector<float> m_inputBuffer;
-    std::vector<float> m_currentSpectrum;
-    static const int FFT_SIZE = 512;
+    std::shared_ptr<const TrackAnalysis> m_trackAnalysis;  // Guarded by m_mutex
+    std::atomic<bool> m_replaying{false};
+    std::atomic<double> m_position{0.0};    // End of the last rendered block
+
+    SampleTap m_tap{65536};
+    std::atomic<bool> m_active{false};
+    std::mutex m_consumerMutex;
+    int m_consumers = 0;
+    std::thread m_thread;
+    std::atomic<bool> m_stopThread{false};
+
+    std::atomic<uint64_t> m_statSpectra{0}, m_statNs{0}, m_statSkipped{0};
 };
@@ -0,0 +1,107 @@
+#include "HeadlessContext.hpp"
+#include <iostream>
+#include <cstring>
+
+#ifdef ABBY_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static bool hasExtension(const char* list, const char* name) {
+    if (!list) return false;
+    size_t length = std::strlen(name);
+    for (const char* p = std::strstr(list, name); p; p = std::strstr(p + length, name)) {
+        if ((p == list || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) return true;
+    }
+    return false;
+}
+
+HeadlessContext::~HeadlessContext() {
+    destroy();
+}
+
+bool HeadlessContext::create(int width, int height) {
+    destroy();
+    if (createOn(eglGetDisplay(EGL_DEFAULT_DISPLAY), width, height)) return true;
+
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay) {
+        std::cerr << "[Headless] No EGL display available" << std::endl;
+        return false;
+    }
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") &&
+        createOn(getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL), width, height)) {
+        return true;
+    }
+    auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+    if (queryDevices && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT devices[8];
+        EGLint count = 0;
+        if (queryDevices(8, devices, &count)) {
+            for (EGLint i = 0; i < count; ++i) {
+                if (createOn(getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], NULL), width, height)) return true;
+            }
+        }
+    }
+    std::cerr << "[Headless] No EGL display with pbuffer and desktop GL support" << std::endl;
+    return false;
+}
+
+bool HeadlessContext::createOn(void* displayHandle, int width, int height) {
+    EGLDisplay display = (EGLDisplay)displayHandle;
+    if (display == EGL_NO_DISPLAY) return false;
+    EGLint major = 0, minor = 0;
+    if (!eglInitialize(display, &major, &minor)) return false;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    EGLConfig config;
+    EGLint configs = 0;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+    if (eglChooseConfig(display, configAttribs, &config, 1, &configs) && configs > 0 && eglBindAPI(EGL_OPENGL_API)) {
+        surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+        if (surface != EGL_NO_SURFACE) context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+    }
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglTerminate(display);
+        return false;
+    }
+
+    m_display = display;
+    m_surface = surface;
+    m_context = context;
+    std::cout << "[Headless] EGL " << major << "." << minor << " (" << eglQueryString(display, EGL_VENDOR)
+              << "), " << width << "x" << height << " pbuffer" << std::endl;
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (!m_display) return;
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context) eglDestroyContext(m_display, m_context);
+    if (m_surface) eglDestroySurface(m_display, m_surface);
+    eglTerminate(m_display);
+    m_display = m_surface = m_context = nullptr;
+}
+
+#else
+
+HeadlessContext::~HeadlessContext() {}
+
+bool HeadlessContext::create(int, int) {
+    std::cerr << "[Headless] Built without EGL, headless rendering is unavailable" << std::endl;
+    return false;
+}
+
+bool HeadlessContext::createOn(void*, int, int) { return false; }
+void HeadlessContext::destroy() {}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ * HeadlessContext - Desktop GL context on an EGL pbuffer, no display needed
+ *
+ * For benchmarking shaders on build machines and CI: Mesa's llvmpipe (or a
+ * real GPU through the device platform) renders into a pbuffer of the
+ * requested size. Displays are tried in order: the default one (X11 or
+ * Wayland when present), Mesa's surfaceless platform, then each EGL device.
+ *
+ * Compiled to a stub that always fails unless ABBY_HAVE_EGL is defined.
+ */
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // Creates the context and makes it current on the calling thread
+    bool create(int width, int height);
+    void destroy();
+
+private:
+    bool createOn(void* display, int width, int height);
+
+    void* m_display = nullptr;   // EGLDisplay
+    void* m_surface = nullptr;   // EGLSurface
+    void* m_context = nullptr;   // EGLContext
+};
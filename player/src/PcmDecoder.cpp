@@ -0,0 +1,38 @@
+#include "PcmDecoder.hpp"
+#include "../include/miniaudio.h"
+#include <iostream>
+
+bool PcmDecoder::decodeFile(const std::string& path, std::vector<unsigned char>& pcm,
+                            unsigned& channels, unsigned& sampleRate) {
+    // Keep native channels/rate, only force the sample format
+    ma_decoder_config config = ma_decoder_config_init(ma_format_s16, 0, 0);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(path.c_str(), &config, &decoder) != MA_SUCCESS) {
+        std::cerr << "[PcmDecoder] Could not decode: " << path << std::endl;
+        return false;
+    }
+
+    channels = decoder.outputChannels;
+    sampleRate = decoder.outputSampleRate;
+    const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(ma_format_s16, channels);
+
+    ma_uint64 totalFrames = 0;
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &totalFrames) == MA_SUCCESS && totalFrames > 0) {
+        pcm.reserve(totalFrames * bytesPerFrame);
+    }
+
+    pcm.clear();
+    std::vector<unsigned char> block(4096 * bytesPerFrame);
+    for (;;) {
+        ma_uint64 framesRead = 0;
+        ma_result result = ma_decoder_read_pcm_frames(&decoder, block.data(), 4096, &framesRead);
+        pcm.insert(pcm.end(), block.begin(), block.begin() + framesRead * bytesPerFrame);
+        if (result != MA_SUCCESS || framesRead == 0) break;
+    }
+
+    ma_decoder_uninit(&decoder);
+
+    std::cout << "[PcmDecoder] Decoded " << pcm.size() / bytesPerFrame << " frames ("
+              << channels << "ch @ " << sampleRate << "Hz)" << std::endl;
+    return !pcm.empty();
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * PcmDecoder - Offline decode of a compressed track to raw PCM
+ *
+ * Output is interleaved signed 16-bit little-endian at the source's native
+ * channel count and sample rate, ready for a PIRA v3 PCM file.
+ */
+class PcmDecoder {
+public:
+    static bool decodeFile(const std::string& path, std::vector<unsigned char>& pcm,
+                           unsigned& channels, unsigned& sampleRate);
+};
@@ -0,0 +1,58 @@
+#include "PcmHistory.hpp"
+#include <cstring>
+
+void PcmHistory::configure(ma_uint32 bytesPerFrame, ma_uint64 capacityFrames) {
+    m_bytesPerFrame = bytesPerFrame;
+    m_capacity = (bytesPerFrame > 0) ? capacityFrames : 0;
+    m_data.assign((size_t)(m_capacity * bytesPerFrame), 0);
+    reset(0);
+}
+
+void PcmHistory::reset(ma_uint64 position) {
+    m_start = position;
+    m_end = position;
+}
+
+void PcmHistory::append(const void* frames, ma_uint32 frameCount) {
+    if (m_capacity == 0 || frameCount == 0) return;
+
+    const unsigned char* src = (const unsigned char*)frames;
+    // Only the tail matters if a single block is larger than the ring
+    if (frameCount > m_capacity) {
+        src += (size_t)(frameCount - m_capacity) * m_bytesPerFrame;
+        m_end += frameCount - m_capacity;
+        m_start = m_end;
+        frameCount = (ma_uint32)m_capacity;
+    }
+
+    ma_uint64 remaining = frameCount;
+    while (remaining > 0) {
+        ma_uint64 slot = m_end % m_capacity;
+        ma_uint64 n = m_capacity - slot;
+        if (n > remaining) n = remaining;
+        std::memcpy(m_data.data() + slot * m_bytesPerFrame, src, (size_t)(n * m_bytesPerFrame));
+        src += n * m_bytesPerFrame;
+        m_end += n;
+        remaining -= n;
+    }
+    if (m_end - m_start > m_capacity) m_start = m_end - m_capacity;
+}
+
+ma_uint32 PcmHistory::read(ma_uint64 position, void* out, ma_uint32 frameCount) const {
+    if (m_capacity == 0 || position < m_start || position >= m_end) return 0;
+
+    ma_uint64 available = m_end - position;
+    ma_uint64 total = (frameCount < available) ? frameCount : available;
+    unsigned char* dst = (unsigned char*)out;
+    ma_uint64 remaining = total;
+    while (remaining > 0) {
+        ma_uint64 slot = position % m_capacity;
+        ma_uint64 n = m_capacity - slot;
+        if (n > remaining) n = remaining;
+        std::memcpy(dst, m_data.data() + slot * m_bytesPerFrame, (size_t)(n * m_bytesPerFrame));
+        dst += n * m_bytesPerFrame;
+        position += n;
+        remaining -= n;
+    }
+    return (ma_uint32)total;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "../include/miniaudio.h"
+
+/**
+ * PcmHistory - Ring of the most recently decoded frames
+ *
+ * Frames are stored in the source format together with their absolute
+ * position in the track, so a seek that lands inside [start, end] can be
+ * replayed from memory while the decoder stays parked at end(). Not
+ * thread-safe: AudioPlayer only touches it under its decoder mutex.
+ */
+class PcmHistory {
+public:
+    // Allocates; call before playback starts (capacity 0 disables the ring)
+    void configure(ma_uint32 bytesPerFrame, ma_uint64 capacityFrames);
+
+    // Forget everything; the next appended frame is at 'position'
+    void reset(ma_uint64 position);
+
+    // Frames that follow end() directly
+    void append(const void* frames, ma_uint32 frameCount);
+
+    // Copies up to frameCount frames starting at 'position'; returns frames copied
+    ma_uint32 read(ma_uint64 position, void* out, ma_uint32 frameCount) const;
+
+    bool contains(ma_uint64 position) const { return m_capacity > 0 && position >= m_start && position <= m_end; }
+    ma_uint64 start() const { return m_start; }
+    ma_uint64 end() const { return m_end; }
+    ma_uint64 capacityFrames() const { return m_capacity; }
+    size_t memoryBytes() const { return m_data.size(); }
+
+private:
+    std::vector<unsigned char> m_data;
+    ma_uint32 m_bytesPerFrame = 0;
+    ma_uint64 m_capacity = 0;
+    ma_uint64 m_start = 0;     // Oldest frame held
+    ma_uint64 m_end = 0;       // One past the newest frame
+};
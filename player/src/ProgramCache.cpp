@@ -0,0 +1,139 @@
+#include "ProgramCache.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+// Entry layout (host byte order, never leaves the machine):
+// [0-3]   Magic "ABPB"
+// [4-7]   Format version (1)
+// [8-15]  Key (sources + driver)
+// [16-19] Binary format (GLenum)
+// [20-23] Binary length
+// Program binary
+static const char MAGIC[4] = { 'A', 'B', 'P', 'B' };
+static const uint32_t FORMAT_VERSION = 1;
+static const size_t HEADER_BYTES = 24;
+static const uint32_t MAX_BINARY_BYTES = 16 * 1024 * 1024;
+
+// FNV-1a, chained over several strings
+static uint64_t hashBytes(uint64_t hash, const std::string& bytes) {
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Separator, so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+ProgramCache::ProgramCache(const std::string& directory) : m_directory(directory) {}
+
+bool ProgramCache::init() {
+    m_enabled = false;
+    if (m_directory.empty()) return false;
+    if (!(GLEW_ARB_get_program_binary || GLEW_VERSION_4_1)) return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) return false;
+
+    auto glString = [](GLenum name) {
+        const GLubyte* s = glGetString(name);
+        return s ? std::string((const char*)s) : std::string();
+    };
+    m_driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    if (ec) {
+        std::cerr << "[ProgramCache] Cannot create " << m_directory << ": " << ec.message() << std::endl;
+        return false;
+    }
+    m_enabled = true;
+    return true;
+}
+
+uint64_t ProgramCache::key(const std::string& vertexSource, const std::string& fragmentSource) const {
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashBytes(hash, m_driver);
+    hash = hashBytes(hash, vertexSource);
+    return hashBytes(hash, fragmentSource);
+}
+
+std::string ProgramCache::pathFor(const std::string& name) const {
+    return m_directory + "/" + name + ".bin";
+}
+
+GLuint ProgramCache::load(const std::string& name, uint64_t key) const {
+    if (!m_enabled) return 0;
+    std::ifstream file(pathFor(name), std::ios::binary);
+    if (!file) return 0;
+
+    char header[HEADER_BYTES];
+    if (!file.read(header, HEADER_BYTES)) return 0;
+    uint32_t version, length;
+    uint64_t storedKey;
+    GLenum format;
+    std::memcpy(&version, header + 4, 4);
+    std::memcpy(&storedKey, header + 8, 8);
+    std::memcpy(&format, header + 16, 4);
+    std::memcpy(&length, header + 20, 4);
+    if (std::memcmp(header, MAGIC, 4) != 0 || version != FORMAT_VERSION || storedKey != key) return 0;
+    if (length == 0 || length > MAX_BINARY_BYTES) return 0;
+
+    std::vector<char> binary(length);
+    if (!file.read(binary.data(), length)) return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)length);
+    // A driver update can reject binaries even with the same version string
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::prepare(GLuint program) const {
+    if (m_enabled) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool ProgramCache::store(const std::string& name, uint64_t key, GLuint program) const {
+    if (!m_enabled) return false;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || (uint32_t)length > MAX_BINARY_BYTES) return false;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return false;
+
+    char header[HEADER_BYTES];
+    uint32_t size = (uint32_t)written;
+    std::memcpy(header, MAGIC, 4);
+    std::memcpy(header + 4, &FORMAT_VERSION, 4);
+    std::memcpy(header + 8, &key, 8);
+    std::memcpy(header + 16, &format, 4);
+    std::memcpy(header + 20, &size, 4);
+
+    std::string path = pathFor(name);
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(header, HEADER_BYTES) || !file.write(binary.data(), written)) {
+            std::cerr << "[ProgramCache] Cannot write " << temp << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    return !ec;
+}
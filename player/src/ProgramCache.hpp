@@ -0,0 +1,43 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <cstdint>
+
+/**
+ * ProgramCache - Linked shader programs kept on disk between runs
+ *
+ * Compiling the whole shader set takes seconds on small GPUs, while
+ * restoring a program binary (glProgramBinary) takes milliseconds. Binaries
+ * are only valid for the driver that produced them, so every entry is keyed
+ * by a hash of both shader sources and the GL vendor, renderer and version
+ * strings; a mismatching or rejected entry is simply a miss and gets
+ * overwritten by the next store(). One file per shader name, written to a
+ * temporary file and renamed so a crash never leaves a torn entry.
+ *
+ * load() and store() only touch the file of the given name and the GL
+ * objects passed in: different programs can be handled from different
+ * (shared) contexts at the same time.
+ */
+class ProgramCache {
+public:
+    explicit ProgramCache(const std::string& directory);
+
+    // Needs a current context; false (and every call a no-op) when the driver has no binary formats
+    bool init();
+    bool isEnabled() const { return m_enabled; }
+
+    uint64_t key(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    // Linked program restored from disk, 0 on a miss
+    GLuint load(const std::string& name, uint64_t key) const;
+    // Before glLinkProgram: asks the driver to keep the binary retrievable
+    void prepare(GLuint program) const;
+    bool store(const std::string& name, uint64_t key, GLuint program) const;
+
+private:
+    std::string pathFor(const std::string& name) const;
+
+    std::string m_directory;
+    std::string m_driver;        // Vendor, renderer and version, part of every key
+    bool m_enabled = false;
+};
@@ -0,0 +1,214 @@
+#include "RealFft.hpp"
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#if !defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+static const double TWO_PI = 6.283185307179586476925;
+
+bool RealFft::isValidSize(int size) {
+    return size >= MIN_SIZE && size <= MAX_SIZE && (size & (size - 1)) == 0;
+}
+
+bool RealFft::simdSupported() {
+#if defined(__SSE2__)
+    return __builtin_cpu_supports("sse2");
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return true;
+#elif defined(__ARM_NEON) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return false;
+#endif
+}
+
+const char* RealFft::simdName() {
+#if defined(__SSE2__)
+    return "SSE2";
+#elif defined(__ARM_NEON)
+    return "NEON";
+#else
+    return "none";
+#endif
+}
+
+RealFft::RealFft(int size, Kernel kernel)
+    : m_size(isValidSize(size) ? size : 512), m_half(m_size / 2) {
+    m_simd = (kernel == Kernel::Simd || kernel == Kernel::Auto) && simdSupported();
+
+    // Same Hann window as the original analyzer
+    m_window.resize(m_size);
+    for (int i = 0; i < m_size; ++i) {
+        m_window[i] = (float)(0.5 * (1.0 - std::cos(TWO_PI * i / (m_size - 1))));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < m_half) ++bits;
+    for (unsigned i = 0; i < (unsigned)m_half; ++i) {
+        unsigned r = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1u << b)) r |= 1u << (bits - 1 - b);
+        }
+        if (i < r) {
+            m_swaps.push_back(i);
+            m_swaps.push_back(r);
+        }
+    }
+
+    // Stages of length 8..m_half: twiddles e^{-2 pi i j / len}, j < len/2
+    for (int len = 8; len <= m_half; len <<= 1) {
+        for (int j = 0; j < len / 2; ++j) {
+            m_twRe.push_back((float)std::cos(TWO_PI * j / len));
+            m_twIm.push_back((float)-std::sin(TWO_PI * j / len));
+        }
+    }
+
+    m_postRe.resize(m_half + 1);
+    m_postIm.resize(m_half + 1);
+    for (int k = 0; k <= m_half; ++k) {
+        m_postRe[k] = (float)std::cos(TWO_PI * k / m_size);
+        m_postIm[k] = (float)-std::sin(TWO_PI * k / m_size);
+    }
+
+    m_re.resize(m_half);
+    m_im.resize(m_half);
+}
+
+// One radix-2 stage: for every block of 'len', x[j] +/- w[j] * x[j + half]
+static void stageScalar(float* re, float* im, const float* wr, const float* wi, int n, int half) {
+    for (int base = 0; base < n; base += 2 * half) {
+        float* ar = re + base;
+        float* ai = im + base;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (int j = 0; j < half; ++j) {
+            float tr = wr[j] * br[j] - wi[j] * bi[j];
+            float ti = wr[j] * bi[j] + wi[j] * br[j];
+            br[j] = ar[j] - tr;
+            bi[j] = ai[j] - ti;
+            ar[j] += tr;
+            ai[j] += ti;
+        }
+    }
+}
+
+// Same stage four butterflies at a time (half >= 4 for every radix-2 stage)
+static void stageSimd(float* re, float* im, const float* wr, const float* wi, int n, int half) {
+#if defined(__SSE2__)
+    for (int base = 0; base < n; base += 2 * half) {
+        float* ar = re + base;
+        float* ai = im + base;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (int j = 0; j < half; j += 4) {
+            __m128 vwr = _mm_loadu_ps(wr + j), vwi = _mm_loadu_ps(wi + j);
+            __m128 vbr = _mm_loadu_ps(br + j), vbi = _mm_loadu_ps(bi + j);
+            __m128 var = _mm_loadu_ps(ar + j), vai = _mm_loadu_ps(ai + j);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(vwr, vbr), _mm_mul_ps(vwi, vbi));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(vwr, vbi), _mm_mul_ps(vwi, vbr));
+            _mm_storeu_ps(br + j, _mm_sub_ps(var, tr));
+            _mm_storeu_ps(bi + j, _mm_sub_ps(vai, ti));
+            _mm_storeu_ps(ar + j, _mm_add_ps(var, tr));
+            _mm_storeu_ps(ai + j, _mm_add_ps(vai, ti));
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (int base = 0; base < n; base += 2 * half) {
+        float* ar = re + base;
+        float* ai = im + base;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (int j = 0; j < half; j += 4) {
+            float32x4_t vwr = vld1q_f32(wr + j), vwi = vld1q_f32(wi + j);
+            float32x4_t vbr = vld1q_f32(br + j), vbi = vld1q_f32(bi + j);
+            float32x4_t var = vld1q_f32(ar + j), vai = vld1q_f32(ai + j);
+            float32x4_t tr = vmlsq_f32(vmulq_f32(vwr, vbr), vwi, vbi);
+            float32x4_t ti = vmlaq_f32(vmulq_f32(vwr, vbi), vwi, vbr);
+            vst1q_f32(br + j, vsubq_f32(var, tr));
+            vst1q_f32(bi + j, vsubq_f32(vai, ti));
+            vst1q_f32(ar + j, vaddq_f32(var, tr));
+            vst1q_f32(ai + j, vaddq_f32(vai, ti));
+        }
+    }
+#else
+    stageScalar(re, im, wr, wi, n, half);
+#endif
+}
+
+void RealFft::complexFft() {
+    float* re = m_re.data();
+    float* im = m_im.data();
+    const int n = m_half;
+
+    for (size_t s = 0; s < m_swaps.size(); s += 2) {
+        unsigned i = m_swaps[s], j = m_swaps[s + 1];
+        float t = re[i]; re[i] = re[j]; re[j] = t;
+        t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+
+    // Stages of length 2 and 4 fused: twiddles are 1 and -i only
+    for (int i = 0; i < n; i += 4) {
+        float a0r = re[i] + re[i + 1],     a0i = im[i] + im[i + 1];
+        float a1r = re[i] - re[i + 1],     a1i = im[i] - im[i + 1];
+        float a2r = re[i + 2] + re[i + 3], a2i = im[i + 2] + im[i + 3];
+        float a3r = re[i + 2] - re[i + 3], a3i = im[i + 2] - im[i + 3];
+        // -i * a3 = (a3i, -a3r)
+        re[i]     = a0r + a2r;  im[i]     = a0i + a2i;
+        re[i + 2] = a0r - a2r;  im[i + 2] = a0i - a2i;
+        re[i + 1] = a1r + a3i;  im[i + 1] = a1i - a3r;
+        re[i + 3] = a1r - a3i;  im[i + 3] = a1i + a3r;
+    }
+
+    size_t tw = 0;
+    for (int len = 8; len <= n; len <<= 1) {
+        int half = len / 2;
+        if (m_simd) stageSimd(re, im, m_twRe.data() + tw, m_twIm.data() + tw, n, half);
+        else stageScalar(re, im, m_twRe.data() + tw, m_twIm.data() + tw, n, half);
+        tw += half;
+    }
+}
+
+void RealFft::transform(const float* input) {
+    // Even samples -> real, odd samples -> imaginary
+    const float* w = m_window.data();
+    for (int i = 0; i < m_half; ++i) {
+        m_re[i] = input[2 * i] * w[2 * i];
+        m_im[i] = input[2 * i + 1] * w[2 * i + 1];
+    }
+    complexFft();
+}
+
+// Split step: X[k] = Fe[k] + W^k * Fo[k], with Fe/Fo recovered from Z[k] and conj(Z[M-k])
+inline void RealFft::splitBin(int k, float& xr, float& xi) const {
+    int a = k & (m_half - 1);
+    int b = (m_half - k) & (m_half - 1);
+    float ar = m_re[a], ai = m_im[a];
+    float br = m_re[b], bi = -m_im[b];
+    float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+    float orr = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+    xr = er + m_postRe[k] * orr - m_postIm[k] * oi;
+    xi = ei + m_postRe[k] * oi + m_postIm[k] * orr;
+}
+
+void RealFft::forward(const float* input, float* outRe, float* outIm) {
+    transform(input);
+    for (int k = 0; k <= m_half; ++k) {
+        splitBin(k, outRe[k], outIm[k]);
+    }
+}
+
+void RealFft::magnitudes(const float* input, float* out) {
+    transform(input);
+    for (int k = 0; k < m_half; ++k) {
+        float xr, xi;
+        splitBin(k, xr, xi);
+        out[k] = std::sqrt(xr * xr + xi * xi);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+
+/**
+ * RealFft - In-place iterative FFT for real input, no allocation per call
+ *
+ * A size-N real transform runs as an N/2 complex FFT (even/odd samples packed
+ * into re/im) followed by a split step. The complex FFT does a bit-reversal
+ * permutation, one radix-4 pass for the first two stages (trivial twiddles),
+ * then radix-2 stages with per-stage contiguous twiddle tables. Window,
+ * twiddle and bit-reversal tables are built once in the constructor.
+ *
+ * The radix-2 stages have an SSE2/NEON path. Which instruction set is chosen
+ * at compile time from the target; the runtime check only decides whether
+ * the compiled-in path is used (ARMv7 cores without NEON).
+ */
+class RealFft {
+public:
+    enum class Kernel { Auto, Scalar, Simd };
+
+    static const int MIN_SIZE = 64;
+    static const int MAX_SIZE = 16384;
+    static bool isValidSize(int size);
+    static bool simdSupported();
+    // Instruction set of the compiled-in SIMD path ("none" without one)
+    static const char* simdName();
+
+    // 'size' must satisfy isValidSize()
+    explicit RealFft(int size = 512, Kernel kernel = Kernel::Auto);
+
+    int size() const { return m_size; }
+    const char* kernelName() const { return m_simd ? "simd" : "scalar"; }
+
+    // Hann-windowed transform of size() samples; bins 0..size()/2 (inclusive)
+    void forward(const float* input, float* outRe, float* outIm);
+
+    // Hann-windowed magnitudes of bins 0..size()/2-1
+    void magnitudes(const float* input, float* out);
+
+private:
+    void complexFft();
+    void transform(const float* input);   // Window + pack + complex FFT into m_re/m_im
+    void splitBin(int k, float& xr, float& xi) const;
+
+    int m_size;
+    int m_half;                       // Complex FFT length
+    bool m_simd;
+    std::vector<float> m_window;
+    std::vector<unsigned> m_swaps;    // Bit-reversal pairs (i, j), i < j
+    std::vector<float> m_twRe, m_twIm;     // Radix-2 stages, concatenated
+    std::vector<float> m_postRe, m_postIm; // Split step, k = 0..m_half
+    std::vector<float> m_re, m_im;         // Work buffers
+};
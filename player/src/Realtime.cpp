@@ -0,0 +1,190 @@
+#include "Realtime.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Rolling buffer (20 chunks) plus decoder/mixer working memory, with headroom
+static const size_t HEAP_RESERVE_BYTES = 8 * 1024 * 1024;
+static const size_t STACK_PREFAULT_BYTES = 64 * 1024;
+
+static std::atomic<bool> s_enabled{false};
+static std::mutex s_mutex;
+static std::string s_memoryStatus;
+static std::string s_roleStatus[(int)Realtime::Role::Count];
+static std::vector<int> s_cpus; // CPUs the process may run on, captured at enable()
+
+static void prefault(void* data, size_t bytes) {
+    volatile unsigned char* p = (volatile unsigned char*)data;
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    for (size_t i = 0; i < bytes; i += (size_t)page) p[i] = p[i];
+}
+
+static void prefaultStack() {
+    volatile unsigned char stack[STACK_PREFAULT_BYTES];
+    prefault((void*)stack, sizeof(stack));
+}
+
+static std::string cpuList(const std::vector<int>& cpus) {
+    std::stringstream ss;
+    for (size_t i = 0; i < cpus.size(); ++i) ss << (i ? "," : "") << cpus[i];
+    return ss.str();
+}
+
+const char* Realtime::roleName(Role role) {
+    switch (role) {
+        case Role::Audio:    return "audio";
+        case Role::Decrypt:  return "decrypt";
+        case Role::Ipc:      return "ipc";
+        case Role::Analysis: return "analysis";
+        case Role::Render:   return "render";
+        case Role::Compile:  return "compile";
+        default:             return "?";
+    }
+}
+
+int Realtime::rolePriority(Role role) {
+    switch (role) {
+        case Role::Audio:    return 80;
+        case Role::Decrypt:  return 60;
+        case Role::Ipc:      return 40;
+        case Role::Analysis: return 30;
+        case Role::Render:   return 20;
+        default:             return 0;
+    }
+}
+
+void Realtime::enable() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_enabled) return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &set)) s_cpus.push_back(i);
+        }
+    }
+
+    std::stringstream mem;
+#ifdef __GLIBC__
+    // Keep freed memory in the (locked) heap instead of returning it to the OS,
+    // and serve large blocks such as decrypted chunks from that heap as well
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    // Grow the heap once and touch it; later chunk allocations reuse these pages
+    void* reserve = malloc(HEAP_RESERVE_BYTES);
+    if (reserve) {
+        prefault(reserve, HEAP_RESERVE_BYTES);
+        free(reserve);
+        mem << "heap " << (HEAP_RESERVE_BYTES >> 20) << "MB prefaulted, ";
+    }
+#endif
+
+    // MCL_FUTURE only when the lock limit cannot make later allocations fail
+    struct rlimit lim;
+    bool unlimited = geteuid() == 0 ||
+                     (getrlimit(RLIMIT_MEMLOCK, &lim) == 0 && lim.rlim_cur == RLIM_INFINITY);
+    int flags = MCL_CURRENT | (unlimited ? MCL_FUTURE : 0);
+    if (mlockall(flags) == 0) {
+        mem << (unlimited ? "mlockall current+future" : "mlockall current only (RLIMIT_MEMLOCK)");
+    } else {
+        mem << "mlockall failed (" << strerror(errno) << ")";
+    }
+    s_memoryStatus = mem.str();
+    s_enabled = true;
+
+    std::cout << "[Realtime] Enabled: " << s_memoryStatus << ", cpus " << cpuList(s_cpus) << std::endl;
+}
+
+bool Realtime::isEnabled() {
+    return s_enabled;
+}
+
+void Realtime::applyToCurrentThread(Role role) {
+    if (!s_enabled) return;
+
+    std::stringstream status;
+
+    // Clamp to what an unprivileged user may request (RLIMIT_RTPRIO)
+    int priority = rolePriority(role);
+    int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    if (priority > maxPriority) priority = maxPriority;
+    struct rlimit rt;
+    if (geteuid() != 0 && getrlimit(RLIMIT_RTPRIO, &rt) == 0 && rt.rlim_cur != RLIM_INFINITY &&
+        (rlim_t)priority > rt.rlim_cur) {
+        priority = (int)rt.rlim_cur;
+    }
+
+    sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int err;
+    if (role == Role::Compile) {
+        // Threads inherit SCHED_FIFO from their creator; dropping it needs no privileges
+        err = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        if (err == 0) status << "SCHED_OTHER";
+        else status << "SCHED_OTHER failed (" << strerror(err) << ")";
+    } else {
+        err = (priority > 0) ? pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) : EPERM;
+        if (err == 0) {
+            status << "SCHED_FIFO " << priority;
+        } else {
+            status << "SCHED_OTHER (" << strerror(err) << ")";
+        }
+    }
+
+    // Audio alone on the last CPU, everything else on the remaining ones
+    if (s_cpus.size() >= 2) {
+        std::vector<int> cpus;
+        if (role == Role::Audio) cpus.push_back(s_cpus.back());
+        else cpus.assign(s_cpus.begin(), s_cpus.end() - 1);
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err == 0) status << ", cpu " << cpuList(cpus);
+        else status << ", affinity failed (" << strerror(err) << ")";
+    } else {
+        status << ", single cpu";
+    }
+
+    prefaultStack();
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_roleStatus[(int)role] = status.str();
+    }
+    std::cout << "[Realtime] " << roleName(role) << ": " << status.str() << std::endl;
+}
+
+std::string Realtime::report() {
+    if (!s_enabled) {
+        return "Realtime: off (start the daemon with --realtime)";
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    std::stringstream ss;
+    ss << "Realtime: on\n";
+    ss << "  memory: " << s_memoryStatus;
+    for (int i = 0; i < (int)Role::Count; ++i) {
+        const std::string& st = s_roleStatus[i];
+        ss << "\n  " << roleName((Role)i) << ": " << (st.empty() ? "not started" : st);
+    }
+    return ss.str();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+/**
+ * Realtime - Scheduling, CPU pinning and memory locking for --realtime
+ *
+ * Each thread calls applyToCurrentThread() with its role once it starts.
+ * Nothing happens unless enable() was called. Every step is best effort:
+ * without CAP_SYS_NICE / CAP_IPC_LOCK (or matching rlimits) the thread
+ * stays SCHED_OTHER and report() says what could not be applied.
+ *
+ * Roles (SCHED_FIFO priority):
+ *   Audio    80  device callback, also runs the decoder and DSP
+ *   Decrypt  60  keeps the rolling buffer ahead of the audio thread
+ *   Ipc      40  socket commands
+ *   Analysis 30  spectrum analysis fed by the audio tap
+ *   Render   20  visualizer, lowest so a heavy shader cannot starve audio
+ *   Compile   -  shader compiles, back to SCHED_OTHER (it would inherit Render)
+ *
+ * With two or more CPUs the audio thread gets the last CPU to itself and
+ * the other roles share the rest.
+ */
+class Realtime {
+public:
+    enum class Role { Audio, Decrypt, Ipc, Analysis, Render, Compile, Count };
+
+    // Lock memory and tune the allocator; call once before threads start
+    static void enable();
+    static bool isEnabled();
+
+    // Scheduling/affinity for the calling thread (no-op when not enabled)
+    static void applyToCurrentThread(Role role);
+
+    static std::string report();
+
+private:
+    static const char* roleName(Role role);
+    static int rolePriority(Role role);
+};
@@ -0,0 +1,50 @@
+#include "ResolutionController.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Climbing only while the mean is this far under the target, and the next step is predicted to fit
+static const float RAISE_BELOW = 0.7f;
+static const float RAISE_FIT = 0.9f;
+// Next quality tier once full resolution uses under this share of the target
+static const float TIER_UP_BELOW = 0.3f;
+
+static float quantize(float scale) {
+    return std::round(scale / ResolutionController::STEP) * ResolutionController::STEP;
+}
+
+void ResolutionController::reset() {
+    m_frames = 0;
+    m_sumMs = 0.0f;
+    m_qualityHint = 0;
+}
+
+int ResolutionController::takeQualityHint() {
+    int hint = m_qualityHint;
+    m_qualityHint = 0;
+    return hint;
+}
+
+float ResolutionController::update(float scale, float renderMs) {
+    float target = m_targetMs;
+    if (target <= 0.0f) return 1.0f;
+
+    m_sumMs += renderMs;
+    if (++m_frames < WINDOW_FRAMES) return scale;
+    float mean = m_sumMs / m_frames;
+    reset();
+
+    if (mean > target) {
+        // Nothing left to save on pixels, the shader itself has to get cheaper
+        if (scale <= MIN_SCALE + 1e-3f) m_qualityHint = -1;
+        float fit = scale * std::sqrt(target / mean);
+        float next = std::floor(fit / STEP + 1e-3f) * STEP;
+        return std::max(MIN_SCALE, std::min(next, quantize(scale) - STEP));
+    }
+    if (scale < 1.0f && mean < target * RAISE_BELOW) {
+        float next = std::min(1.0f, quantize(scale) + STEP);
+        float predicted = mean * (next * next) / (scale * scale);
+        if (predicted < target * RAISE_FIT) return next;
+    }
+    if (scale >= 1.0f && mean < target * TIER_UP_BELOW) m_qualityHint = 1;
+    return scale;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+
+/**
+ * ResolutionController - Render scale that keeps a shader inside its frame budget
+ *
+ * Fragment cost grows with the pixel count, i.e. with the scale squared.
+ * Every WINDOW_FRAMES frames the mean render time is compared with the
+ * target: above it the scale drops straight to the estimated fit, well
+ * below it the scale climbs one STEP if the prediction still fits, so a
+ * shader settles instead of oscillating. Scales are multiples of STEP so
+ * the offscreen buffer is only reallocated when something really changed.
+ * Past both ends it hints at a quality tier change instead: down when even
+ * MIN_SCALE misses the target, up when full resolution leaves most of it.
+ *
+ * The target may be set from any thread, the rest is render thread only.
+ * The visualizer keeps one scale per shader and calls reset() on a switch.
+ */
+class ResolutionController {
+public:
+    static constexpr float MIN_SCALE = 0.35f;
+    static constexpr float STEP = 0.05f;
+    static const int WINDOW_FRAMES = 20;
+
+    // Render time budget in ms; 0 turns adaptation off (always full resolution)
+    void setTargetMs(float ms) { m_targetMs = ms > 0.0f ? ms : 0.0f; }
+    float getTargetMs() const { return m_targetMs; }
+
+    // Discards the partial measurement window
+    void reset();
+
+    // One frame at 'scale' took renderMs; returns the scale for the next frames
+    float update(float scale, float renderMs);
+    // -1 (lower tier), +1 (higher tier) or 0, from the last completed window; reading clears it
+    int takeQualityHint();
+
+private:
+    std::atomic<float> m_targetMs{12.0f};
+    int m_frames = 0;
+    float m_sumMs = 0.0f;
+    int m_qualityHint = 0;
+};
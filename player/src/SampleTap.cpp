@@ -0,0 +1,55 @@
+#include "SampleTap.hpp"
+#include <cstring>
+
+SampleTap::SampleTap(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    m_buffer.assign(size, 0.0f);
+    m_mask = size - 1;
+}
+
+size_t SampleTap::push(const float* samples, size_t count) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    size_t space = m_buffer.size() - (head - tail);
+    if (count > space) {
+        m_dropped.fetch_add(count - space, std::memory_order_relaxed);
+        count = space;
+    }
+
+    size_t offset = head & m_mask;
+    size_t first = m_buffer.size() - offset;
+    if (first > count) first = count;
+    std::memcpy(m_buffer.data() + offset, samples, first * sizeof(float));
+    std::memcpy(m_buffer.data(), samples + first, (count - first) * sizeof(float));
+
+    m_head.store(head + count, std::memory_order_release);
+    return count;
+}
+
+size_t SampleTap::pop(float* out, size_t count) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    if (count > head - tail) count = head - tail;
+
+    size_t offset = tail & m_mask;
+    size_t first = m_buffer.size() - offset;
+    if (first > count) first = count;
+    std::memcpy(out, m_buffer.data() + offset, first * sizeof(float));
+    std::memcpy(out + first, m_buffer.data(), (count - first) * sizeof(float));
+
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+size_t SampleTap::skip(size_t count) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    if (count > head - tail) count = head - tail;
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+size_t SampleTap::available() const {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * SampleTap - Lock-free single-producer/single-consumer float ring
+ *
+ * The audio thread pushes, one analysis thread pops. push() never blocks or
+ * allocates: when the consumer falls behind, the samples that do not fit
+ * are dropped and counted.
+ */
+class SampleTap {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SampleTap(size_t capacity = 32768);
+
+    // Producer: returns samples written
+    size_t push(const float* samples, size_t count);
+
+    // Consumer
+    size_t pop(float* out, size_t count);
+    size_t skip(size_t count);
+    size_t available() const;
+
+    size_t capacity() const { return m_buffer.size(); }
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    std::vector<float> m_buffer;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_head{0};  // Next write, owned by the producer
+    alignas(64) std::atomic<size_t> m_tail{0};  // Next read, owned by the consumer
+    std::atomic<uint64_t> m_dropped{0};
+};
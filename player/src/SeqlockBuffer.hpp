@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+/**
+ * SeqlockBuffer - Latest-value float snapshot, one writer, any number of readers
+ *
+ * The writer never waits and readers never lock or allocate: they copy into
+ * their own storage and retry if a write overlapped the copy. Every write
+ * bumps the generation, so a reader passing its last generation back gets
+ * false (and no copy) when nothing changed. Generation 0 means "never
+ * written"; pass NO_GENERATION to always copy. An optional 64-bit stamp
+ * (e.g. a stream position) travels with each write.
+ */
+template <size_t Capacity>
+class SeqlockBuffer {
+public:
+    static constexpr uint64_t NO_GENERATION = ~0ull;
+
+    // Writer only; count <= Capacity
+    void write(const float* values, size_t count, uint64_t stamp = 0) {
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_count.store(count, std::memory_order_relaxed);
+        m_stamp.store(stamp, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            m_data[i].store(values[i], std::memory_order_relaxed);
+        }
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies up to 'capacity' values if newer than 'generation'; 'count' gets the stored size
+    bool read(float* out, size_t capacity, size_t& count, uint64_t& generation, uint64_t* stamp = nullptr) const {
+        for (;;) {
+            uint64_t before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (before / 2 == generation) return false;
+
+            size_t stored = m_count.load(std::memory_order_relaxed);
+            uint64_t storedStamp = m_stamp.load(std::memory_order_relaxed);
+            size_t n = (stored < capacity) ? stored : capacity;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = m_data[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == before) {
+                count = stored;
+                generation = before / 2;
+                if (stamp) *stamp = storedStamp;
+                return true;
+            }
+        }
+    }
+
+    uint64_t generation() const { return m_seq.load(std::memory_order_acquire) / 2; }
+    // Unvalidated peek, for picking a buffer before read()ing it
+    uint64_t stamp() const { return m_stamp.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint64_t> m_seq{0};
+    std::atomic<size_t> m_count{0};
+    std::atomic<uint64_t> m_stamp{0};
+    std::atomic<float> m_data[Capacity] = {};
+};
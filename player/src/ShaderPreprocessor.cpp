@@ -0,0 +1,101 @@
+#include "ShaderPreprocessor.hpp"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+static const int MAX_INCLUDE_DEPTH = 8;
+
+// GLSL up to 1.50: the line after '#line L S' is line L + 1 of source string S
+static std::string lineDirective(int nextLine, int sourceIndex) {
+    return "#line " + std::to_string(nextLine - 1) + " " + std::to_string(sourceIndex) + "\n";
+}
+
+// True for an #include line; 'file' stays empty when the name is not quoted
+static bool parseInclude(const std::string& line, std::string& file) {
+    size_t pos = line.find_first_not_of(" \t");
+    if (pos == std::string::npos || line[pos] != '#') return false;
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) return false;
+    size_t open = line.find('"', pos + 7);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    file = close == std::string::npos ? std::string() : line.substr(open + 1, close - open - 1);
+    return true;
+}
+
+ShaderPreprocessor::ShaderPreprocessor(const std::string& directory) : m_directory(directory) {}
+
+bool ShaderPreprocessor::hasPragma(const std::string& source, const std::string& name) {
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#') continue;
+        std::istringstream words(line.substr(pos + 1));
+        std::string directive, word;
+        if (words >> directive >> word && directive == "pragma" && word == name) return true;
+    }
+    return false;
+}
+
+bool ShaderPreprocessor::expand(const std::string& file, const std::string& source, int quality,
+                                std::string& output, std::vector<std::string>& files, std::string& error) const {
+    output.clear();
+    files.assign(1, file);
+    quality = std::clamp(quality, 0, QUALITY_TIERS - 1);
+
+    // #version must stay the first thing the compiler sees
+    std::string body = source;
+    int firstLine = 1;
+    size_t start = source.find_first_not_of(" \t\r\n");
+    if (start != std::string::npos && source.compare(start, 8, "#version") == 0) {
+        size_t end = source.find('\n', start);
+        output = source.substr(0, end == std::string::npos ? source.size() : end) + "\n";
+        body = end == std::string::npos ? std::string() : source.substr(end + 1);
+        firstLine = (int)std::count(source.begin(), source.begin() + (end == std::string::npos ? source.size() : end), '\n') + 2;
+    }
+    output += "#define QUALITY " + std::to_string(quality) + "\n";
+    output += lineDirective(firstLine, 0);
+    return expandInto(body, 0, firstLine, 0, output, files, error);
+}
+
+bool ShaderPreprocessor::expandInto(const std::string& source, int sourceIndex, int firstLine, int depth,
+                                    std::string& output, std::vector<std::string>& files, std::string& error) const {
+    std::istringstream lines(source);
+    std::string line;
+    for (int number = firstLine; std::getline(lines, line); ++number) {
+        auto where = [&]() { return files[sourceIndex] + ":" + std::to_string(number) + ": "; };
+        std::string file;
+        if (!parseInclude(line, file)) {
+            output += line;
+            output += '\n';
+            continue;
+        }
+        if (file.empty()) {
+            error = where() + "expected #include \"file\"";
+            return false;
+        }
+        // Already included: an empty line keeps the numbering
+        if (std::find(files.begin(), files.end(), file) != files.end()) {
+            output += '\n';
+            continue;
+        }
+        if (depth >= MAX_INCLUDE_DEPTH) {
+            error = where() + "includes nested deeper than " + std::to_string(MAX_INCLUDE_DEPTH);
+            return false;
+        }
+        std::ifstream in(m_directory + "/" + file);
+        if (!in) {
+            error = where() + "cannot open " + file;
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+
+        files.push_back(file);
+        int included = (int)files.size() - 1;
+        output += lineDirective(1, included);
+        if (!expandInto(text.str(), included, 1, depth + 1, output, files, error)) return false;
+        output += lineDirective(number + 1, sourceIndex);
+    }
+    return true;
+}
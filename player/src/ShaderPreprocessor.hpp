@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * ShaderPreprocessor - Expands #include and defines QUALITY before a shader is compiled
+ *
+ * GLSL 1.10 has no includes, so every .frag file used to repeat the uniform
+ * declarations. A line '#include "file"' is replaced by that file from the
+ * shader directory, unconditionally (it runs before the GLSL preprocessor,
+ * #if around an include does not apply). Includes nest; a file that was
+ * already pulled in is skipped, as if it had include guards.
+ *
+ * '#define QUALITY n' comes first (after #version, if any). Tiers are
+ * 0 low, 1 medium, 2 high (the hand-tuned defaults) and 3 ultra; shaders
+ * pick loop counts and similar constants per tier with TIER() from
+ * prelude.glsl, so every tier is its own specialized program.
+ *
+ * '#pragma <name>' lines are left to the player (GLSL ignores unknown
+ * pragmas): '#pragma feedback' asks for the previous frame, see
+ * FeedbackBuffer. Like includes they apply whatever #if they sit in.
+ *
+ * #line directives keep compiler messages pointing at the original lines:
+ * source string N is files[N], 0 being the shader itself (some drivers,
+ * Mesa for one, only print the line).
+ *
+ * Only reads files, safe to use from several threads.
+ */
+class ShaderPreprocessor {
+public:
+    static const int QUALITY_TIERS = 4;
+
+    explicit ShaderPreprocessor(const std::string& directory);
+
+    // 'source' (read from 'file') ready to compile; false with the reason in 'error'
+    bool expand(const std::string& file, const std::string& source, int quality,
+                std::string& output, std::vector<std::string>& files, std::string& error) const;
+    // True when 'source' (expanded, to see included files) has a line '#pragma name'
+    static bool hasPragma(const std::string& source, const std::string& name);
+
+private:
+    bool expandInto(const std::string& source, int sourceIndex, int firstLine, int depth,
+                    std::string& output, std::vector<std::string>& files, std::string& error) const;
+
+    std::string m_directory;
+};
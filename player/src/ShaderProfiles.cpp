@@ -0,0 +1,79 @@
+#include "ShaderProfiles.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+ShaderProfiles::ShaderProfiles(const std::string& path) : m_path(path) {}
+
+bool ShaderProfiles::load(const std::string& renderer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_renderer = renderer;
+    m_entries.clear();
+    std::ifstream file(m_path);
+    if (!file) return false;
+
+    std::string line;
+    if (!std::getline(file, line) || line != "renderer " + renderer) return false;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        int quality = 0;
+        Entry entry;
+        if (fields >> name >> quality >> entry.msPerMegapixel >> std::hex >> entry.sourceKey) {
+            m_entries[{name, quality}] = entry;
+        }
+    }
+    return true;
+}
+
+bool ShaderProfiles::save() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_path.empty()) return false;
+    std::error_code ec;
+    fs::create_directories(fs::path(m_path).parent_path(), ec);
+
+    std::string temp = m_path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        file << "renderer " << m_renderer << "\n";
+        for (const auto& [key, entry] : m_entries) {
+            file << key.first << " " << key.second << " " << std::fixed << std::setprecision(3) << entry.msPerMegapixel
+                 << " " << std::hex << entry.sourceKey << std::dec << "\n";
+        }
+        if (!file) {
+            std::cerr << "[ShaderProfiles] Cannot write " << temp << std::endl;
+            return false;
+        }
+    }
+    fs::rename(temp, m_path, ec);
+    return !ec;
+}
+
+void ShaderProfiles::validate(const std::string& name, int quality, uint64_t sourceKey) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find({name, quality});
+    if (it != m_entries.end() && it->second.sourceKey != sourceKey) m_entries.erase(it);
+}
+
+void ShaderProfiles::forget(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->first.first == name) it = m_entries.erase(it);
+        else ++it;
+    }
+}
+
+void ShaderProfiles::record(const std::string& name, int quality, uint64_t sourceKey, float msPerMegapixel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[{name, quality}] = Entry{ msPerMegapixel, sourceKey };
+}
+
+float ShaderProfiles::msPerMegapixel(const std::string& name, int quality) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find({name, quality});
+    return it == m_entries.end() ? -1.0f : it->second.msPerMegapixel;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * ShaderProfiles - Measured cost of every shader on this machine, kept between runs
+ *
+ * Cost is render time per megapixel at a quality tier: fragment work scales
+ * with the pixel count, so one number covers every window size and render
+ * scale. The visualizer measures a shader the first time it draws it at a
+ * tier; --bench-shaders measures all of them at once. Each entry remembers
+ * the program cache key of the preprocessed source at its tier, so editing
+ * the shader, an include or the prelude drops it; so does writing the whole
+ * file for another renderer.
+ *
+ * Text file, one entry per line after the renderer line:
+ *   <shader> <tier> <ms per megapixel> <source key>
+ *
+ * All methods lock, the daemon's command thread reads while the render
+ * thread records.
+ */
+class ShaderProfiles {
+public:
+    explicit ShaderProfiles(const std::string& path);
+
+    // Reads the file, keeping only entries measured on 'renderer'; false when there is none
+    bool load(const std::string& renderer);
+    bool save() const;
+    const std::string& path() const { return m_path; }
+
+    // Drops the entry of 'name' at 'quality' if it was measured on other source
+    void validate(const std::string& name, int quality, uint64_t sourceKey);
+    void forget(const std::string& name);
+
+    // 'sourceKey' is ProgramCache::key() of the preprocessed source at 'quality'
+    void record(const std::string& name, int quality, uint64_t sourceKey, float msPerMegapixel);
+    // Negative when not measured
+    float msPerMegapixel(const std::string& name, int quality) const;
+
+private:
+    struct Entry {
+        float msPerMegapixel;
+        uint64_t sourceKey;
+    };
+    std::string m_path;
+    std::string m_renderer;
+    std::map<std::pair<std::string, int>, Entry> m_entries;
+    mutable std::mutex m_mutex;
+};
@@ -1,14 +1,26 @@
 #include "ShaderVisualizer.hpp"
 #include "ResourceManager.hpp"
+#include "Realtime.hpp"
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
 
 namespace fs = std::filesystem;
 
+// Cost profiling of a newly drawn shader: frames skipped (driver warm-up), then frames averaged
+static const int PROFILE_WARMUP_FRAMES = 10;
+static const int PROFILE_FRAMES = 60;
+// Frames between re-evaluations of which shaders are too slow to step to
+static const int SKIP_CHECK_FRAMES = 120;
+// Longest u_timeDelta: after a stall (a shader build, a slow idle frame) incremental effects step, not leap
+static const float MAX_TIME_DELTA = 0.25f;
+
 const char* ShaderVisualizer::VERTEX_SOURCE = R"(
     attribute vec2 position;
     varying vec2 v_uv;
@@ -18,6 +30,20 @@ const char* ShaderVisualizer::VERTEX_SOURCE = R"(
     }
 )";
 
+// Stretches the reduced-scale frame over the window
+const char* ShaderVisualizer::BLIT_SOURCE = R"(
+    uniform sampler2D u_frame;
+    varying vec2 v_uv;
+    void main() {
+        gl_FragColor = texture2D(u_frame, v_uv);
+    }
+)";
+
+const char* const ShaderVisualizer::UNIFORM_NAMES[UNIFORM_COUNT] = {
+    "u_time", "u_pitch", "u_pos", "u_duration", "u_features", "u_spectrogramHead", "u_timeDelta",
+    "u_spectrum", "u_spectrumStereo", "u_waveform", "u_spectrogram", "u_prevFrame"
+};
+
 void ShaderVisualizer::loadShaders() {
     m_programs.clear();
     
@@ -30,39 +56,321 @@ void ShaderVisualizer::loadShaders() {
     }
     
     std::cout << "[Visuals] Using shader directory: " << shaderDir << std::endl;
+    m_shaderDir = shaderDir;
+    m_preprocessor = std::make_unique<ShaderPreprocessor>(shaderDir);
+    int quality = m_quality >= 0 ? (int)m_quality : DEFAULT_QUALITY;
 
     for (const auto& entry : fs::directory_iterator(shaderDir)) {
         if (entry.path().extension() == ".frag") {
             std::string path = entry.path().string();
             std::string name = entry.path().stem().string();
             
-            std::cout << "[Visuals] Loading shader: " << name << "..." << std::endl;
-            
-            std::cout << "[Visuals] Loading shader file content: " << name << "..." << std::endl;
-            
             std::ifstream file(path);
             if (!file) continue;
             
             std::stringstream buffer;
             buffer << file.rdbuf();
-            std::string source = buffer.str();
             
-            std::cout << "[Visuals] Creating program for " << name << "..." << std::endl;
-            GLuint prog = createProgram(VERTEX_SOURCE, source.c_str());
-            if (prog != 0) {
-                m_programs.push_back({prog, name});
-                std::cout << "[Visuals] Loaded " << name << " successfully." << std::endl;
-            } else {
-                std::cerr << "[Visuals] Failed to compile " << name << std::endl;
-            }
+            auto program = std::make_unique<ShaderProgram>();
+            program->name = name;
+            program->source = buffer.str();
+            program->quality = quality;
+            m_programs.push_back(std::move(program));
         }
     }
     
     if (m_programs.empty()) {
-        std::cerr << "[Visuals] No valid shaders found in " << shaderDir << std::endl;
+        std::cerr << "[Visuals] No shaders found in " << shaderDir << std::endl;
+    }
+}
+
+bool ShaderVisualizer::buildProgram(ShaderProgram& program) {
+    int expected = PENDING;
+    if (!program.state.compare_exchange_strong(expected, BUILDING)) return false;
+    
+    Uint32 start = SDL_GetTicks();
+    bool cached = false;
+    std::string expanded;
+    uint64_t key = 0;
+    GLuint id = 0;
+    if (expandSource(program.name, program.source, program.quality, expanded, key)) {
+        id = linkProgram(program.name, program.quality, expanded, key, cached);
+        program.feedback = ShaderPreprocessor::hasPragma(expanded, "feedback");
+    }
+    program.cacheKey = key;
+    if (id == 0) {
+        std::cerr << "[Visuals] Failed to compile " << program.name << std::endl;
+        program.state = FAILED;
+        return false;
+    }
+    
+    program.id = id;
+    resolveLocations(program);
+    // Other contexts only see a complete program after the commands have run
+    glFinish();
+    program.state = READY;
+    std::cout << "[Visuals] " << program.name << (cached ? ": cached binary, " : ": compiled, ")
+              << (SDL_GetTicks() - start) << " ms" << std::endl;
+    return true;
+}
+
+bool ShaderVisualizer::expandSource(const std::string& name, const std::string& source, int quality,
+                                    std::string& expanded, uint64_t& cacheKey) const {
+    std::vector<std::string> files;
+    std::string error;
+    if (!m_preprocessor->expand(name + ".frag", source, quality, expanded, files, error)) {
+        std::cerr << "[Visuals] " << error << std::endl;
+        return false;
+    }
+    cacheKey = m_cache->key(VERTEX_SOURCE, expanded);
+    return true;
+}
+
+GLuint ShaderVisualizer::linkProgram(const std::string& name, int quality, const std::string& source, uint64_t cacheKey,
+                                     bool& cached) {
+    std::string entry = name + ".q" + std::to_string(quality);
+    cached = true;
+    GLuint id = m_cache->load(entry, cacheKey);
+    if (id == 0) {
+        cached = false;
+        id = createProgram(VERTEX_SOURCE, source.c_str());
+        if (id != 0) m_cache->store(entry, cacheKey, id);
+    }
+    return id;
+}
+
+bool ShaderVisualizer::reloadShader(const std::string& name) {
+    std::ifstream file(m_shaderDir + "/" + name + ".frag");
+    if (!file) return true;  // Already gone again
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string source = buffer.str();
+    
+    ShaderProgram* existing = nullptr;
+    for (auto& program : m_programs) {
+        if (program->name == name) existing = program.get();
+    }
+    // resolveLocations() leaves no program bound
+    m_boundProgram = 0;
+    
+    if (!existing) {
+        auto program = std::make_unique<ShaderProgram>();
+        program->name = name;
+        program->source = source;
+        program->quality = m_quality >= 0 ? (int)m_quality : DEFAULT_QUALITY;
+        // Kept even if it fails, the next save may fix it
+        buildProgram(*program);
+        std::lock_guard<std::mutex> lock(m_programsMutex);
+        m_programs.push_back(std::move(program));
+        std::cout << "[Visuals] Added shader " << name << std::endl;
+        return true;
+    }
+    
+    int state = existing->state;
+    if (state == BUILDING) return false;
+    if (state == PENDING) {
+        // Not built yet: take it over and build the new source
+        if (!existing->state.compare_exchange_strong(state, BUILDING)) return false;
+        existing->source = source;
+        m_profiles->forget(name);
+        existing->tooSlow = false;
+        existing->state = PENDING;
+        buildProgram(*existing);
+        return true;
+    }
+    
+    // READY and FAILED programs only change on this thread. Unchanged after preprocessing
+    // (saved as is, or an include it does not use) means nothing to do.
+    std::string expanded;
+    uint64_t key = 0;
+    bool expandedOk = expandSource(name, source, existing->quality, expanded, key);
+    if (expandedOk && key == existing->cacheKey) return true;
+    // A new source may build at tiers that failed before, and costs something else
+    existing->failedTiers = 0;
+    m_profiles->forget(name);
+    existing->tooSlow = false;
+    if (state == FAILED) {
+        existing->source = source;
+        existing->state = PENDING;
+        buildProgram(*existing);
+        return true;
+    }
+    if (!expandedOk || !relinkProgram(*existing, source, existing->quality)) {
+        std::cerr << "[Visuals] Keeping the previous " << name << std::endl;
+        return true;
+    }
+    // Its cost changed, let the resolution controller start over
+    existing->scale = 1.0f;
+    std::cout << "[Visuals] Reloaded " << name << std::endl;
+    return true;
+}
+
+bool ShaderVisualizer::relinkProgram(ShaderProgram& program, const std::string& source, int quality) {
+    std::string expanded;
+    uint64_t key = 0;
+    bool cached = false;
+    if (!expandSource(program.name, source, quality, expanded, key)) return false;
+    GLuint id = linkProgram(program.name, quality, expanded, key, cached);
+    if (id == 0) return false;
+    // Only this thread uses id and uniforms of a READY program, they can be swapped in place
+    GLuint previous = program.id;
+    program.id = id;
+    program.source = source;
+    program.cacheKey = key;
+    program.quality = quality;
+    program.feedback = ShaderPreprocessor::hasPragma(expanded, "feedback");
+    resolveLocations(program);
+    glDeleteProgram(previous);
+    m_boundProgram = 0;
+    return true;
+}
+
+int ShaderVisualizer::stepProgram(int index, int direction) const {
+    int count = (int)m_programs.size();
+    for (int i = 1; i <= count; ++i) {
+        int candidate = ((index + direction * i) % count + count) % count;
+        if (m_programs[candidate]->state != FAILED && !m_programs[candidate]->tooSlow) return candidate;
+    }
+    return index;
+}
+
+bool ShaderVisualizer::changeQuality(ShaderProgram& program, int quality) {
+    if (quality == program.quality || (program.failedTiers & (1 << quality))) return false;
+    int previous = program.quality;
+    if (!relinkProgram(program, program.source, quality)) {
+        std::cerr << "[Visuals] " << program.name << ": quality " << quality << " failed to build" << std::endl;
+        program.failedTiers |= 1 << quality;
+        return false;
+    }
+    std::cout << "[Visuals] " << program.name << ": quality " << previous << " -> " << quality << std::endl;
+    m_resolution.reset();
+    return true;
+}
+
+float ShaderVisualizer::frameBudgetMs() const {
+    float target = m_resolution.getTargetMs();
+    return target > 0.0f ? target : 1000.0f / m_scheduler.getTargetFps();
+}
+
+bool ShaderVisualizer::measureFrame(const ShaderProgram& program) {
+    Measurement& m = m_measurement;
+    if (m.program != &program || m.id != program.id) {
+        m = Measurement();
+        m.program = &program;
+        m.id = program.id;
+        m.active = m_profiles->msPerMegapixel(program.name, program.quality) < 0.0f;
+    }
+    return m.active;
+}
+
+void ShaderVisualizer::recordMeasurement(ShaderProgram& program, float renderMs) {
+    Measurement& m = m_measurement;
+    if (++m.frames <= PROFILE_WARMUP_FRAMES) return;
+    m.msPerMegapixel += renderMs * 1e6f / std::max(1, m_renderWidth * m_renderHeight);
+    if (m.frames < PROFILE_WARMUP_FRAMES + PROFILE_FRAMES) return;
+
+    float cost = m.msPerMegapixel / PROFILE_FRAMES;
+    m.active = false;
+    m_profiles->record(program.name, program.quality, program.cacheKey, cost);
+    m_profiles->save();
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2) << cost;
+    std::cout << "[Visuals] " << program.name << ": " << ss.str() << " ms per megapixel at quality "
+              << program.quality << std::endl;
+    applyProfile(program);
+    updateSkips();
+}
+
+void ShaderVisualizer::applyProfile(ShaderProgram& program) {
+    float target = m_resolution.getTargetMs();
+    float cost = m_profiles->msPerMegapixel(program.name, program.quality);
+    // Full resolution wanted, or nothing known yet
+    if (target <= 0.0f || cost < 0.0f) return;
+    float fullMs = cost * m_drawableWidth * m_drawableHeight / 1e6f;
+    if (fullMs <= target) return;
+    
+    // Straight to the scale that fits instead of letting the controller find it
+    const float minScale = ResolutionController::MIN_SCALE;
+    float fit = std::sqrt(target / fullMs);
+    if (fit >= minScale || m_quality >= 0 || program.quality == 0) {
+        float step = ResolutionController::STEP;
+        program.scale = std::min((float)program.scale, std::max(minScale, std::floor(fit / step + 1e-3f) * step));
+        return;
+    }
+    // Even the smallest scale misses: a tier down now, which gets measured in turn
+    changeQuality(program, program.quality - 1);
+}
+
+void ShaderVisualizer::updateSkips() {
+    float budget = frameBudgetMs();
+    float minScale = m_fbo && m_resolution.getTargetMs() > 0.0f ? ResolutionController::MIN_SCALE : 1.0f;
+    float megapixels = m_drawableWidth * m_drawableHeight * minScale * minScale / 1e6f;
+    int pinned = m_quality;
+    for (const auto& program : m_programs) {
+        // Judged at the cheapest tier it may run at; not measured there means usable
+        float cost = m_profiles->msPerMegapixel(program->name, pinned >= 0 ? pinned : 0);
+        program->tooSlow = cost >= 0.0f && cost * megapixels > budget;
+    }
+}
+
+bool ShaderVisualizer::createCompileContext() {
+    // Shares objects with m_glContext, which must be current here
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    m_compileWindow = SDL_CreateWindow("Abby Shader Compiler", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                                       1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (m_compileWindow) m_compileContext = SDL_GL_CreateContext(m_compileWindow);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    // Creating a context makes it current
+    SDL_GL_MakeCurrent(m_window, m_glContext);
+    
+    if (!m_compileContext) {
+        std::cerr << "[Visuals] No shared context (" << SDL_GetError() << "), compiling shaders on demand" << std::endl;
+        destroyCompileContext();
+        return false;
+    }
+    return true;
+}
+
+void ShaderVisualizer::destroyCompileContext() {
+    if (m_compileContext) {
+        SDL_GL_DeleteContext(m_compileContext);
+        m_compileContext = nullptr;
+    }
+    if (m_compileWindow) {
+        SDL_DestroyWindow(m_compileWindow);
+        m_compileWindow = nullptr;
     }
 }
 
+void ShaderVisualizer::compileLoop() {
+    // Would inherit the render thread's SCHED_FIFO; a long link must not hold up frames
+    Realtime::applyToCurrentThread(Realtime::Role::Compile);
+    if (SDL_GL_MakeCurrent(m_compileWindow, m_compileContext) != 0) {
+        std::cerr << "[Visuals] Compile context unusable: " << SDL_GetError() << std::endl;
+        return;
+    }
+    Uint32 start = SDL_GetTicks();
+    int built = 0;
+    for (size_t i = 0; m_running; ++i) {
+        ShaderProgram* program = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_programsMutex);
+            if (i >= m_programs.size()) break;
+            program = m_programs[i].get();
+        }
+        if (buildProgram(*program)) built++;
+    }
+    SDL_GL_MakeCurrent(m_compileWindow, nullptr);
+    
+    std::lock_guard<std::mutex> lock(m_programsMutex);
+    int ready = 0;
+    for (const auto& program : m_programs) {
+        if (program->state == READY) ready++;
+    }
+    std::cout << "[Visuals] " << ready << "/" << m_programs.size() << " shaders ready ("
+              << built << " built in background, " << (SDL_GetTicks() - start) << " ms)" << std::endl;
+}
+
 ShaderVisualizer::ShaderVisualizer(std::shared_ptr<FrequencyAnalyzer> analyzer, AudioPlayer* player) 
     : m_analyzer(analyzer), m_player(player), m_running(false), m_window(nullptr), m_glContext(nullptr) {}
 
@@ -71,6 +379,7 @@ ShaderVisualizer::~ShaderVisualizer() {
 }
 
 bool ShaderVisualizer::init() {
+    m_initTicks = SDL_GetTicks();
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
         return false;
@@ -107,18 +416,47 @@ bool ShaderVisualizer::init() {
     }
     std::cout << "[Visuals] OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
 
-    // Enable VSync
-    SDL_GL_SetSwapInterval(1);
+    // Enable VSync; at or below the target rate it paces the loop by itself
+    if (SDL_GL_SetSwapInterval(1) == 0) {
+        SDL_DisplayMode mode;
+        if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(m_window), &mode) == 0) {
+            m_scheduler.setVsyncHz(mode.refresh_rate);
+        }
+    }
 
-    // Compile Shaders
+    return initRenderer(true);
+}
+
+bool ShaderVisualizer::initRenderer(bool backgroundCompile) {
+    // Only the first working shader is built before the first frame, see compileLoop()
+    m_cache = std::make_unique<ProgramCache>(Abby::ResourceManager::instance().getUserConfigDir() + "/shader-cache");
+    if (!m_cache->init()) {
+        std::cout << "[Visuals] Program binaries not supported, shaders are compiled every start" << std::endl;
+    }
     loadShaders();
-    if (m_programs.empty()) {
+    std::string configDir = Abby::ResourceManager::instance().getUserConfigDir();
+    m_profiles = std::make_unique<ShaderProfiles>(configDir.empty() ? std::string() : configDir + "/shader-profiles.txt");
+    const GLubyte* renderer = glGetString(GL_RENDERER);
+    m_profiles->load(renderer ? (const char*)renderer : "");
+    // Per tier, keyed like the program binaries: an edited include or prelude counts too
+    for (const auto& program : m_programs) {
+        for (int tier = 0; tier < ShaderPreprocessor::QUALITY_TIERS; ++tier) {
+            std::string expanded, error;
+            std::vector<std::string> files;
+            if (m_preprocessor->expand(program->name + ".frag", program->source, tier, expanded, files, error)) {
+                m_profiles->validate(program->name, tier, m_cache->key(VERTEX_SOURCE, expanded));
+            }
+        }
+    }
+    m_currentProgramIndex = -1;
+    for (size_t i = 0; i < m_programs.size() && m_currentProgramIndex < 0; ++i) {
+        if (buildProgram(*m_programs[i])) m_currentProgramIndex = (int)i;
+    }
+    if (m_currentProgramIndex < 0) {
         std::cerr << "No shaders loaded!" << std::endl;
         return false;
     }
-    // Set initial program
-    m_currentProgramIndex = 0;
-    // m_program is not needed as member anymore, we use m_programs[index].id
+    if (backgroundCompile) createCompileContext();
 
     // Fullscreen Quad Setup
     float vertices[] = {
@@ -128,22 +466,114 @@ bool ShaderVisualizer::init() {
          1.0f,  1.0f
     };
 
+    // Vertex state is set once: every program reads 'position' from POSITION_ATTRIB
+    if (GLEW_ARB_vertex_array_object || GLEW_VERSION_3_0) {
+        glGenVertexArrays(1, &m_vao);
+        glBindVertexArray(m_vao);
+    }
     glGenBuffers(1, &m_vbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(POSITION_ATTRIB);
+    glVertexAttribPointer(POSITION_ATTRIB, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    // Analysis textures on units 0..2
+    m_spectrumTexture = createDataTexture(SPECTRUM_BANDS, 1);
+    m_stereoTexture = createDataTexture(SPECTRUM_BANDS, 2);
+    m_waveformTexture = createDataTexture(FrequencyAnalyzer::WAVEFORM_POINTS, 2);
+    const GLuint dataTextures[] = { m_spectrumTexture, m_stereoTexture, m_waveformTexture };
+    for (int unit = 0; unit < 3; ++unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, dataTextures[unit]);
+    }
+    glActiveTexture(GL_TEXTURE0 + SPECTROGRAM_TEXTURE_UNIT);
+    m_spectrogramTexture = createDataTexture(SPECTRUM_BANDS, SPECTROGRAM_ROWS);
+    // Wraps in time so sampling across the write head interpolates between neighbouring rows
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    m_spectrogramHead = 0;
+    // Feedback shaders without feedback must read a cleared state, not texture 0's opaque black
+    glActiveTexture(GL_TEXTURE0 + FEEDBACK_TEXTURE_UNIT);
+    glGenTextures(1, &m_noFeedbackTexture);
+    glBindTexture(GL_TEXTURE_2D, m_noFeedbackTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    const uint8_t transparent[4] = { 0, 0, 0, 0 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+    glActiveTexture(GL_TEXTURE0);
+    if (createFramebuffer()) {
+        m_feedback = std::make_unique<FeedbackBuffer>(FEEDBACK_TEXTURE_UNIT);
+        if (!m_feedback->create()) m_feedback.reset();
+    }
+
+    return true;
+}
 
-    // Texture Setup for Spectrum
-    glGenTextures(1, &m_spectrumTexture);
-    glBindTexture(GL_TEXTURE_2D, m_spectrumTexture);
+bool ShaderVisualizer::createFramebuffer() {
+    if (!(GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object)) {
+        std::cout << "[Visuals] No framebuffer objects, every shader renders at full resolution" << std::endl;
+        return false;
+    }
+    m_blitProgram = createProgram(VERTEX_SOURCE, BLIT_SOURCE);
+    if (m_blitProgram == 0) return false;
+    glUseProgram(m_blitProgram);
+    m_blitFrameLocation = glGetUniformLocation(m_blitProgram, "u_frame");
+    glUniform1i(m_blitFrameLocation, FRAME_TEXTURE_UNIT);
+    m_blitUnit = FRAME_TEXTURE_UNIT;
+    glUseProgram(0);
+    
+    glGenTextures(1, &m_frameTexture);
+    glActiveTexture(GL_TEXTURE0 + FRAME_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, m_frameTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // Clamp to edge to avoid artifacts at 0.0 and 1.0
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0);
+    
+    glGenFramebuffers(1, &m_fbo);
+    return true;
+}
 
+bool ShaderVisualizer::resizeFramebuffer(int width, int height) {
+    if (width == m_frameWidth && height == m_frameHeight) return true;
+    
+    glActiveTexture(GL_TEXTURE0 + FRAME_TEXTURE_UNIT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glActiveTexture(GL_TEXTURE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_frameTexture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        // Not retried every frame: fall back to full resolution for good
+        std::cerr << "[Visuals] Framebuffer incomplete (0x" << std::hex << status << std::dec
+                  << "), rendering at full resolution" << std::endl;
+        glDeleteFramebuffers(1, &m_fbo);
+        m_fbo = 0;
+        return false;
+    }
+    m_frameWidth = width;
+    m_frameHeight = height;
     return true;
 }
 
+GLuint ShaderVisualizer::createDataTexture(int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Clamp to edge to avoid artifacts at 0.0 and 1.0
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Rows are not 4-byte multiples for every size
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    std::vector<uint8_t> black((size_t)width * height, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, black.data());
+    return texture;
+}
+
 void ShaderVisualizer::run() {
     if (m_running) return;
     m_running = true;
@@ -163,13 +593,33 @@ void ShaderVisualizer::requestStop() {
 void ShaderVisualizer::renderLoop() {
     // Make context current in this thread
     SDL_GL_MakeCurrent(m_window, m_glContext);
+    if (m_compileContext) {
+        m_compileThread = std::thread(&ShaderVisualizer::compileLoop, this);
+    }
+    if (!m_shaderDir.empty() && m_watcher.start(m_shaderDir)) {
+        std::cout << "[Visuals] Watching " << m_shaderDir << " for changes" << std::endl;
+    }
+    std::vector<std::string> reloads;   // Changed shaders still waiting for the compile thread
+    
+    // Spectrum analysis only runs while we are drawing it
+    m_analyzer->setSpectrumBands(SPECTRUM_BANDS);
+    m_analyzer->acquire();
     
-    // Prepare blank texture data
-    // Prepare blank texture data
-    std::vector<uint8_t> textureData(256, 0); // 256 bands, usually enough for texture
+    // Reused every frame; textures are only re-uploaded when a new frame was published
+    const int points = FrequencyAnalyzer::WAVEFORM_POINTS;
+    std::vector<float> spectrum(2 * SPECTRUM_BANDS, 0.0f), waveform(2 * points, 0.0f);
+    uint64_t spectrumGeneration = 0, stereoGeneration = 0, waveformGeneration = 0;
     
     float startTime = (float)SDL_GetTicks() / 1000.0f;
     float lastSwitchTime = startTime;
+    float previousTime = 0.0f;
+    
+    using Clock = std::chrono::steady_clock;
+    auto msSince = [](Clock::time_point t) { return std::chrono::duration<float, std::milli>(Clock::now() - t).count(); };
+    auto average = [](std::atomic<float>& avg, float sample) { avg = avg + (sample - avg) * 0.05f; };
+    Clock::time_point lastFrame = Clock::now();
+    m_boundProgram = 0;
+    int drawnIndex = m_currentProgramIndex;   // Shown while the selected one is still building
 
     while (m_running) {
         // Event Polling (Essential for SDL to not hang)
@@ -181,63 +631,133 @@ void ShaderVisualizer::renderLoop() {
             // Allow manual switch with key
             if (e.type == SDL_KEYDOWN) {
                  if (e.key.keysym.sym == SDLK_SPACE) {
-                     m_currentProgramIndex = (m_currentProgramIndex + 1) % m_programs.size();
+                     m_currentProgramIndex = stepProgram(m_currentProgramIndex, 1);
                  }
             }
         }
         
+        // Hot reload between frames; any shader may use a changed include, unaffected ones are skipped
+        for (const std::string& file : m_watcher.poll()) {
+            std::vector<std::string> names;
+            if (file.size() > 5 && file.compare(file.size() - 5, 5, ".frag") == 0) {
+                names.push_back(file.substr(0, file.size() - 5));
+            } else {
+                for (const auto& program : m_programs) names.push_back(program->name);
+            }
+            for (const std::string& name : names) {
+                if (std::find(reloads.begin(), reloads.end(), name) == reloads.end()) reloads.push_back(name);
+            }
+        }
+        reloads.erase(std::remove_if(reloads.begin(), reloads.end(),
+                                     [this](const std::string& name) { return reloadShader(name); }),
+                      reloads.end());
+        
+        Clock::time_point frameStart = Clock::now();
+        
         // 1. Get Analysis Data
-        std::vector<float> spectrum = m_analyzer->getSpectrum(256);
-        float pitch = m_analyzer->getDominantFrequency(44100.0f); // approx sample rate
+        AudioFeatures features = m_analyzer->getFeatures();
         AudioPlayer::PlaybackState playback = m_player->getPlaybackState();
+        m_scheduler.update(playback.isPlaying, features.rms);
+        FrameUniforms uniforms;
+        features.packUniforms(uniforms.features);
+        uniforms.pitch = features.dominantHz;
+        uniforms.position = playback.currentTime;
+        uniforms.duration = (playback.totalTime > 0 ? playback.totalTime : 1.0f);
         
         // Auto-switch disabled - manual control only
         float currentTime = (float)SDL_GetTicks() / 1000.0f - startTime;
+        uniforms.time = currentTime;
+        uniforms.timeDelta = std::min(currentTime - previousTime, MAX_TIME_DELTA);
+        previousTime = currentTime;
         // if (currentTime - lastSwitchTime > 10.0f) {
         //     m_currentProgramIndex = (m_currentProgramIndex + 1) % m_programs.size();
         //     lastSwitchTime = currentTime;
         // }
 
         // Texture Update
-        for(size_t i=0; i<256 && i<spectrum.size(); ++i) {
-            float val = spectrum[i] * 255.0f;
-            if (val > 255.0f) val = 255.0f;
-            textureData[i] = (uint8_t)val;
+        if (m_analyzer->readSpectrum(spectrum.data(), SPECTRUM_BANDS, spectrumGeneration)) {
+            uploadTexture(m_spectrumTexture, 0, SPECTRUM_BANDS, 1, spectrum.data(), 1.0f, 0.0f);
+            pushSpectrogramRow(spectrum.data());
+        }
+        uint64_t rightGeneration = stereoGeneration;
+        if (m_analyzer->readSpectrum(spectrum.data(), SPECTRUM_BANDS, stereoGeneration, FrequencyAnalyzer::Channel::Left) &&
+            m_analyzer->readSpectrum(spectrum.data() + SPECTRUM_BANDS, SPECTRUM_BANDS, rightGeneration, FrequencyAnalyzer::Channel::Right)) {
+            uploadTexture(m_stereoTexture, 1, SPECTRUM_BANDS, 2, spectrum.data(), 1.0f, 0.0f);
+        }
+        if (m_analyzer->readWaveform(waveform.data(), waveformGeneration)) {
+            uploadTexture(m_waveformTexture, 2, points, 2, waveform.data(), 0.5f, 0.5f);
         }
-        
-        glBindTexture(GL_TEXTURE_2D, m_spectrumTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, 256, 1, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, textureData.data());
 
         // 2. Render
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        int drawableWidth = 0, drawableHeight = 0;
+        SDL_GL_GetDrawableSize(m_window, &drawableWidth, &drawableHeight);
+        m_drawableWidth = drawableWidth;
+        m_drawableHeight = drawableHeight;
         
-        GLuint prog = m_programs[m_currentProgramIndex].id;
-        glUseProgram(prog);
+        // Profiles change with the budget and the window: re-judged now and then. A default
+        // known to miss the budget is left for the next usable shader once, at startup.
+        if (m_statFrames % SKIP_CHECK_FRAMES == 0) {
+            updateSkips();
+            if (m_statFrames == 0 && m_programs[m_currentProgramIndex]->tooSlow) {
+                int next = stepProgram(m_currentProgramIndex, 1);
+                if (next != m_currentProgramIndex) {
+                    std::cout << "[Visuals] Skipping " << m_programs[m_currentProgramIndex]->name
+                              << ", too slow for this device" << std::endl;
+                    m_currentProgramIndex = next;
+                }
+            }
+            if (m_statFrames == 0) applyProfile(*m_programs[drawnIndex]);
+        }
         
-        GLint posAttrib = glGetAttribLocation(prog, "position");
-        GLint timeUniform = glGetUniformLocation(prog, "u_time");
-        GLint pitchUniform = glGetUniformLocation(prog, "u_pitch");
-        GLint posUniform = glGetUniformLocation(prog, "u_pos");
-        GLint durUniform = glGetUniformLocation(prog, "u_duration");
-        GLint specUniform = glGetUniformLocation(prog, "u_spectrum");
-
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        glEnableVertexAttribArray(posAttrib);
-        glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        // Without a compile thread the selected shader is built on demand
+        int selectedIndex = m_currentProgramIndex;
+        ShaderProgram& selected = *m_programs[selectedIndex];
+        if (selected.state == PENDING && buildProgram(selected)) m_boundProgram = 0;
+        if (selected.state == READY && drawnIndex != selectedIndex) {
+            drawnIndex = selectedIndex;
+            m_resolution.reset();
+            applyProfile(selected);
+        }
+        ShaderProgram& program = *m_programs[drawnIndex];
         
-        glUniform1f(timeUniform, currentTime);
-        glUniform1f(pitchUniform, pitch);
-        glUniform1f(posUniform, playback.currentTime);
-        glUniform1f(durUniform, (playback.totalTime > 0 ? playback.totalTime : 1.0f));
-        glUniform1i(specUniform, 0); // Texture unit 0
+        bool measuring = measureFrame(program);
+        float scale = program.scale;
+        Clock::time_point renderStart = Clock::now();
+        drawFrame(program, uniforms, drawableWidth, drawableHeight);
+        average(m_avgSubmitMs, msSince(frameStart));
         
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        // The controller and the profile need what the GPU spent, not just the submit
+        if (m_resolution.getTargetMs() > 0.0f || measuring) glFinish();
+        float renderMs = msSince(renderStart);
+        average(m_avgRenderMs, renderMs);
+        program.scale = m_resolution.update(scale, renderMs);
+        if (measuring) recordMeasurement(program, renderMs);
+        
+        // Quality tier: the pinned one, or a step where the controller ran out of scale (or headroom)
+        int hint = m_resolution.takeQualityHint();
+        int pinned = m_quality;
+        changeQuality(program, std::clamp(pinned >= 0 ? pinned : program.quality + hint, 0,
+                                          ShaderPreprocessor::QUALITY_TIERS - 1));
         
+        Clock::time_point swapStart = Clock::now();
         SDL_GL_SwapWindow(m_window);
+        average(m_avgSwapMs, msSince(swapStart));
+        average(m_avgFrameMs, msSince(lastFrame));
+        lastFrame = Clock::now();
+        if (m_statFrames++ == 0) {
+            std::cout << "[Visuals] First frame " << (SDL_GetTicks() - m_initTicks) << " ms after init" << std::endl;
+        }
         
-        SDL_Delay(16);
+        m_scheduler.wait([this](float& rms) {
+            rms = m_analyzer->getFeatures().rms;
+            return m_player->getPlaybackState().isPlaying;
+        });
     }
+    
+    m_analyzer->release();
+    m_watcher.stop();
+    if (m_compileThread.joinable()) m_compileThread.join();
+    destroyCompileContext();
 
     if (m_window) {
         SDL_DestroyWindow(m_window);
@@ -246,8 +766,100 @@ void ShaderVisualizer::renderLoop() {
     SDL_Quit();
 }
 
+void ShaderVisualizer::uploadTexture(GLuint texture, int unit, int width, int height, const float* values,
+                                     float scale, float offset, int row) {
+    size_t count = (size_t)width * height;
+    if (m_textureBytes.size() < count) m_textureBytes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        float val = (values[i] * scale + offset) * 255.0f;
+        m_textureBytes[i] = (uint8_t)(val < 0.0f ? 0.0f : (val > 255.0f ? 255.0f : val));
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_textureBytes.data());
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ShaderVisualizer::pushSpectrogramRow(const float* spectrum) {
+    m_spectrogramHead = (m_spectrogramHead + 1) % SPECTROGRAM_ROWS;
+    uploadTexture(m_spectrogramTexture, SPECTROGRAM_TEXTURE_UNIT, SPECTRUM_BANDS, 1, spectrum, 1.0f, 0.0f, m_spectrogramHead);
+}
+
+void ShaderVisualizer::drawFrame(const ShaderProgram& program, const FrameUniforms& uniforms,
+                                 int drawableWidth, int drawableHeight) {
+    // Heavy shaders draw into the offscreen frame at their own scale, feedback
+    // shaders into their next state at any scale
+    float scale = std::min((float)program.scale, 1.0f);
+    int width = std::max(1, (int)std::lround(drawableWidth * scale));
+    int height = std::max(1, (int)std::lround(drawableHeight * scale));
+    bool feedback = program.feedback && m_feedback;
+    if (feedback) {
+        // State from before a switch (another shader's, or stale) means nothing now
+        if (m_feedbackOwner != &program) {
+            m_feedback->clear();
+            m_feedbackOwner = &program;
+        }
+        feedback = m_feedback->begin(width, height);
+        if (!feedback) {
+            // Its textures are gone with it
+            m_feedback.reset();
+            glActiveTexture(GL_TEXTURE0 + FEEDBACK_TEXTURE_UNIT);
+            glBindTexture(GL_TEXTURE_2D, m_noFeedbackTexture);
+            glActiveTexture(GL_TEXTURE0);
+        }
+    } else {
+        m_feedbackOwner = nullptr;
+    }
+    bool offscreen = feedback;
+    if (!feedback && m_fbo && scale < 1.0f) offscreen = resizeFramebuffer(width, height);
+    if (!offscreen) {
+        width = drawableWidth;
+        height = drawableHeight;
+    }
+    
+    if (!feedback && m_fbo) glBindFramebuffer(GL_FRAMEBUFFER, offscreen ? m_fbo : 0);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    
+    // Locations and texture units were resolved at link time (-1 is ignored by GL)
+    if (program.id != m_boundProgram) {
+        glUseProgram(program.id);
+        m_boundProgram = program.id;
+    }
+    const GLint* loc = program.uniforms;
+    glUniform1f(loc[U_TIME], uniforms.time);
+    glUniform1f(loc[U_PITCH], uniforms.pitch);
+    glUniform1f(loc[U_POS], uniforms.position);
+    glUniform1f(loc[U_DURATION], uniforms.duration);
+    glUniform4fv(loc[U_FEATURES], AudioFeatures::UNIFORM_VEC4S, uniforms.features);
+    glUniform1f(loc[U_SPECTROGRAM_HEAD], (m_spectrogramHead + 0.5f) / SPECTROGRAM_ROWS);
+    glUniform1f(loc[U_TIME_DELTA], uniforms.timeDelta);
+    
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    
+    if (offscreen) {
+        // The state just drawn is the next frame's u_prevFrame, and what the window shows
+        int unit = FRAME_TEXTURE_UNIT;
+        if (feedback) {
+            m_feedback->end();
+            unit = FEEDBACK_TEXTURE_UNIT;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, drawableWidth, drawableHeight);
+        glUseProgram(m_blitProgram);
+        m_boundProgram = m_blitProgram;
+        if (unit != m_blitUnit) {
+            glUniform1i(m_blitFrameLocation, unit);
+            m_blitUnit = unit;
+        }
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    m_renderWidth = width;
+    m_renderHeight = height;
+}
+
 GLuint ShaderVisualizer::compileShader(GLenum type, const char* source) {
-    std::cout << "[Visuals] Compiling shader type " << type << "..." << std::endl;
     GLuint shader = glCreateShader(type);
     if (shader == 0) {
         std::cerr << "[Visuals] glCreateShader failed! Error: " << glGetError() << std::endl;
@@ -263,47 +875,146 @@ GLuint ShaderVisualizer::compileShader(GLenum type, const char* source) {
         char buffer[512];
         glGetShaderInfoLog(shader, 512, NULL, buffer);
         std::cerr << "Shader Compile Error: " << buffer << std::endl;
+        glDeleteShader(shader);
         return 0;
     }
-    std::cout << "[Visuals] Shader compiled successfully: " << shader << std::endl;
     return shader;
 }
 
 GLuint ShaderVisualizer::createProgram(const char* vertexSource, const char* fragmentSource) {
-    std::cout << "[Visuals] Creating program..." << std::endl;
     GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
     GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
     
-    if (vertexShader == 0 || fragmentShader == 0) return 0;
+    if (vertexShader == 0 || fragmentShader == 0) {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
     
     GLuint program = glCreateProgram();
-    std::cout << "[Visuals] Attaching shaders to program " << program << "..." << std::endl;
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
-    std::cout << "[Visuals] Linking program..." << std::endl;
+    glBindAttribLocation(program, POSITION_ATTRIB, "position");
+    m_cache->prepare(program);
     glLinkProgram(program);
+    // The program keeps what it needs, the shader objects can go
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
     
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char buffer[512];
+        glGetProgramInfoLog(program, 512, NULL, buffer);
+        std::cerr << "Program Link Error: " << buffer << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
     return program;
 }
 
-void ShaderVisualizer::handleShaderCommand(const std::string& cmd) {
-    if (cmd.empty()) return;
+void ShaderVisualizer::resolveLocations(ShaderProgram& program) {
+    std::fill(program.uniforms, program.uniforms + UNIFORM_COUNT, -1);
     
-    if (cmd == "next") {
-        m_currentProgramIndex = (m_currentProgramIndex + 1) % m_programs.size();
-        std::cout << "[Visuals] Switched to shader: " << m_programs[m_currentProgramIndex].name << std::endl;
-    } else if (cmd == "prev") {
-        m_currentProgramIndex = (m_currentProgramIndex - 1 + m_programs.size()) % m_programs.size();
-        std::cout << "[Visuals] Switched to shader: " << m_programs[m_currentProgramIndex].name << std::endl;
-    } else {
-        // Try to find shader by name
-        for (size_t i = 0; i < m_programs.size(); ++i) {
-            if (m_programs[i].name == cmd) {
-                m_currentProgramIndex = i;
-                std::cout << "[Visuals] Switched to shader: " << cmd << std::endl;
-                return;
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(std::max(maxLength, 1), '\0');
+    for (GLint i = 0; i < count; ++i) {
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program.id, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+        // Arrays are reported as "u_features[0]"
+        std::string base(name.data());
+        base = base.substr(0, base.find('['));
+        for (int u = 0; u < UNIFORM_COUNT; ++u) {
+            if (base == UNIFORM_NAMES[u]) program.uniforms[u] = glGetUniformLocation(program.id, UNIFORM_NAMES[u]);
+        }
+    }
+    
+    // Sampler units are program state, they never change
+    glUseProgram(program.id);
+    glUniform1i(program.uniforms[U_SPECTRUM], 0);
+    glUniform1i(program.uniforms[U_SPECTRUM_STEREO], 1);
+    glUniform1i(program.uniforms[U_WAVEFORM], 2);
+    glUniform1i(program.uniforms[U_SPECTROGRAM], SPECTROGRAM_TEXTURE_UNIT);
+    glUniform1i(program.uniforms[U_PREV_FRAME], FEEDBACK_TEXTURE_UNIT);
+    glUseProgram(0);
+}
+
+std::string ShaderVisualizer::getFrameStats() const {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    std::lock_guard<std::mutex> lock(m_programsMutex);
+    int index = m_currentProgramIndex;
+    if (index >= 0 && index < (int)m_programs.size()) ss << "shader " << m_programs[index]->name << ", ";
+    int ready = 0;
+    for (const auto& program : m_programs) {
+        if (program->state == READY) ready++;
+    }
+    ss << ready << "/" << m_programs.size() << " built, ";
+    if (index >= 0 && index < (int)m_programs.size()) {
+        ss << "scale " << m_programs[index]->scale << " (" << m_renderWidth << "x" << m_renderHeight << "), quality "
+           << m_programs[index]->quality << (m_quality >= 0 ? " (pinned), " : " (auto), ");
+    }
+    float target = m_resolution.getTargetMs();
+    ss << "render " << m_avgRenderMs << " ms";
+    if (target > 0.0f) ss << " (target " << target << " ms)";
+    else ss << " (adaptive resolution off)";
+    ss << ", ";
+    float frameMs = m_avgFrameMs;
+    ss << (frameMs > 0.0f ? 1000.0f / frameMs : 0.0f) << " fps (target " << std::setprecision(0)
+       << m_scheduler.getTargetFps() << ", idle " << m_scheduler.getIdleFps() << std::setprecision(2)
+       << (m_scheduler.isIdle() ? ", idling" : "") << ", " << m_scheduler.getLateFrames() << " late), submit " << m_avgSubmitMs
+       << " ms, swap " << m_avgSwapMs << " ms per frame, " << m_statFrames << " frames";
+    return ss.str();
+}
+
+std::string ShaderVisualizer::handleShaderCommand(const std::string& cmd) {
+    if (cmd.empty() || cmd == "list") return describeShaders();
+    std::lock_guard<std::mutex> lock(m_programsMutex);
+    
+    if (cmd == "next" || cmd == "prev") {
+        m_currentProgramIndex = stepProgram(m_currentProgramIndex, cmd == "next" ? 1 : -1);
+        std::cout << "[Visuals] Switched to shader: " << m_programs[m_currentProgramIndex]->name << std::endl;
+        return "Switched to shader: " + m_programs[m_currentProgramIndex]->name;
+    }
+    // Try to find shader by name; an explicit choice is allowed to be slow
+    for (size_t i = 0; i < m_programs.size(); ++i) {
+        if (m_programs[i]->name == cmd) {
+            if (m_programs[i]->state == FAILED) {
+                std::cerr << "[Visuals] Shader failed to compile: " << cmd << std::endl;
+                return "ERROR: Shader failed to compile: " + cmd;
             }
+            m_currentProgramIndex = (int)i;
+            std::cout << "[Visuals] Switched to shader: " << cmd << std::endl;
+            return "Switched to shader: " + cmd + (m_programs[i]->tooSlow ? " (too slow for the frame budget)" : "");
+        }
+    }
+    std::cerr << "[Visuals] Shader not found: " << cmd << std::endl;
+    return "ERROR: Shader not found: " + cmd;
+}
+
+std::string ShaderVisualizer::describeShaders() const {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    int width = m_drawableWidth, height = m_drawableHeight;
+    float megapixels = width * height / 1e6f;
+    ss << "Frame budget " << frameBudgetMs() << " ms at " << width << "x" << height
+       << ", measured full-resolution ms per quality tier (0-3):";
+    std::lock_guard<std::mutex> lock(m_programsMutex);
+    for (size_t i = 0; i < m_programs.size(); ++i) {
+        const ShaderProgram& program = *m_programs[i];
+        static const char* const STATES[] = { "pending", "building", "ready", "failed" };
+        ss << "\n" << ((int)i == m_currentProgramIndex ? "* " : "  ") << std::left << std::setw(16) << program.name
+           << std::setw(9) << STATES[program.state] << "q" << program.quality << std::right;
+        for (int tier = 0; tier < ShaderPreprocessor::QUALITY_TIERS; ++tier) {
+            float cost = m_profiles ? m_profiles->msPerMegapixel(program.name, tier) : -1.0f;
+            if (cost < 0.0f) ss << std::setw(8) << "-";
+            else ss << std::setw(8) << cost * megapixels;
         }
-        std::cerr << "[Visuals] Shader not found: " << cmd << std::endl;
+        if (program.tooSlow) ss << "  skipped";
+        if (program.feedback) ss << "  feedback";
     }
+    return ss.str();
 }
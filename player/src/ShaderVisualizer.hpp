@@ -14,8 +14,36 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
 #include "AudioPlayer.hpp" // Now needs AudioPlayer for playback state
+#include "ProgramCache.hpp"
+#include "ResolutionController.hpp"
+#include "FrameScheduler.hpp"
+#include "HeadlessContext.hpp"
+#include "ShaderWatcher.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "ShaderProfiles.hpp"
+#include "FeedbackBuffer.hpp"
 
+/**
+ * ShaderVisualizer - Fullscreen fragment shaders driven by the analyzer
+ *
+ * Startup only builds the first shader: the rest are restored from the
+ * ProgramCache or compiled on a background thread with a shared GL context,
+ * or on demand when selected if no shared context could be created.
+ * While running, the shader directory is watched: a saved .frag is rebuilt
+ * between frames (the old program stays if the new source fails) and new
+ * files are added to the list.
+ *
+ * Shaders too heavy for the frame budget are drawn into an offscreen
+ * framebuffer at a reduced scale, picked per shader by a
+ * ResolutionController, and stretched to the window. Shaders declaring
+ * '#pragma feedback' always draw offscreen, into the next state of a
+ * FeedbackBuffer, and read the previous one as u_prevFrame.
+ *
+ * The same loading and drawing code also runs without a display on an EGL
+ * pbuffer, for the --bench-shaders benchmark.
+ */
 class ShaderVisualizer {
 public:
     ShaderVisualizer(std::shared_ptr<FrequencyAnalyzer> analyzer, AudioPlayer* player);
@@ -24,21 +52,139 @@ public:
     bool init();
     void run(); 
     void requestStop();
-    void handleShaderCommand(const std::string& cmd);
+    // next, prev, list (measured costs) or a shader name; returns the reply for the client
+    std::string handleShaderCommand(const std::string& cmd);
+    // Current shader and moving-average frame timing, for 'visuals status'
+    std::string getFrameStats() const;
+    // Render time budget for the resolution controller, 0 = always full resolution
+    void setFrameTarget(float ms) { m_resolution.setTargetMs(ms); }
+    // Frame rate while audio plays, and while it is paused, stopped or silent
+    void setFrameRate(float fps, float idleFps) { m_scheduler.setTargetFps(fps); m_scheduler.setIdleFps(idleFps); }
+    // Quality tier (0-3) for every shader, or -1: per shader, following the render target
+    void setQuality(int tier) { m_quality = tier; }
+
+    // Headless benchmark (--bench-shaders): every shader for a number of frames on synthetic input
+    struct BenchOptions {
+        int width = 800;
+        int height = 480;
+        int frames = 300;
+        std::string shader;      // Only this one (empty = all)
+        std::string dumpDir;     // Writes <shader>.ppm of the last frame when set
+        int quality = 2;         // Tier every shader is built at
+    };
+    // Process exit code: 0, or 1 without a context or when a shader failed to build
+    static int runBenchmark(const BenchOptions& options);
 
 private:
     void renderLoop();
+    // EGL pbuffer instead of an SDL window, see ShaderVisualizer_bench.cpp
+    bool initHeadless(int width, int height);
+    int benchmark(const BenchOptions& options);
     GLuint compileShader(GLenum type, const char* source);
     GLuint createProgram(const char* vertexSource, const char* fragmentSource);
+    // Shared context on a hidden window for compileLoop(), false if the driver refuses
+    bool createCompileContext();
+    void compileLoop();
+    void destroyCompileContext();
+    // GL state shared by the window and headless paths; needs a current context
+    bool initRenderer(bool backgroundCompile);
+    // Luminance texture, allocated once (black) and updated with glTexSubImage2D
+    GLuint createDataTexture(int width, int height);
+    // values * scale + offset (0..1) as bytes into rows [row, row + height) of 'texture', which stays bound on 'unit'
+    void uploadTexture(GLuint texture, int unit, int width, int height, const float* values, float scale, float offset,
+                       int row = 0);
+    // Writes a new mix spectrum over the oldest spectrogram row and advances the head
+    void pushSpectrogramRow(const float* spectrum);
+    // Offscreen target for reduced-scale rendering; false if framebuffers are unsupported
+    bool createFramebuffer();
+    bool resizeFramebuffer(int width, int height);
 
-    // Shader Management
+    // Shader Management: reads the sources, programs are built later
     void loadShaders();
+    // Uniforms the render loop sets, looked up once per program at link time
+    enum Uniform { U_TIME, U_PITCH, U_POS, U_DURATION, U_FEATURES, U_SPECTROGRAM_HEAD, U_TIME_DELTA,
+                   U_SPECTRUM, U_SPECTRUM_STEREO, U_WAVEFORM, U_SPECTROGRAM, U_PREV_FRAME, UNIFORM_COUNT };
+    static const char* const UNIFORM_NAMES[UNIFORM_COUNT];
+    static const GLuint POSITION_ATTRIB = 0; // Bound before linking, so one vertex setup fits all
+    enum ProgramState { PENDING, BUILDING, READY, FAILED };
+    static const int DEFAULT_QUALITY = 2;
     struct ShaderProgram {
-        GLuint id;
+        GLuint id = 0;
         std::string name;
+        std::string source;                  // As read from the file, see ShaderPreprocessor
+        uint64_t cacheKey = 0;               // Of the preprocessed source id was built from
+        GLint uniforms[UNIFORM_COUNT];       // -1 when the shader does not use it
+        std::atomic<int> state{PENDING};     // id and uniforms are valid once READY
+        std::atomic<float> scale{1.0f};      // Render scale chosen by m_resolution
+        std::atomic<int> quality{DEFAULT_QUALITY};
+        int failedTiers = 0;                 // Bit per tier that did not build; render thread, cleared on reload
+        std::atomic<bool> tooSlow{false};    // Misses the budget even at its cheapest tier, next/prev skip it
+        std::atomic<bool> feedback{false};   // '#pragma feedback': drawn through m_feedback
+    };
+    // Claims a PENDING program and builds it in the current context; false if taken or failed
+    bool buildProgram(ShaderProgram& program);
+    // Preprocessed source of a shader at a quality tier and its cache key; false (logged) on errors
+    bool expandSource(const std::string& name, const std::string& source, int quality,
+                      std::string& expanded, uint64_t& cacheKey) const;
+    // From the cache or compiled (and then cached), one cache entry per tier; 0 on failure
+    GLuint linkProgram(const std::string& name, int quality, const std::string& source, uint64_t cacheKey, bool& cached);
+    // Render thread: picks up a changed or new file; false = busy on the compile thread, retry later
+    bool reloadShader(const std::string& name);
+    // Render thread, READY program: swaps in 'source' at 'quality'; keeps the old program on failure
+    bool relinkProgram(ShaderProgram& program, const std::string& source, int quality);
+    // Relinks at another tier unless that one failed before; logs either way
+    bool changeQuality(ShaderProgram& program, int quality);
+    // Render time one frame may take: the resolution target, else the frame period
+    float frameBudgetMs() const;
+    // Cost profiling, render thread. True while 'program' is being timed (the frame needs a glFinish)
+    bool measureFrame(const ShaderProgram& program);
+    void recordMeasurement(ShaderProgram& program, float renderMs);
+    // Scale (or tier) that fits the budget according to the profile, on a switch or a new measurement
+    void applyProfile(ShaderProgram& program);
+    // Re-evaluates tooSlow for every shader
+    void updateSkips();
+    std::string describeShaders() const;
+    // Fills the location table from the active uniforms and assigns the texture units
+    void resolveLocations(ShaderProgram& program);
+    // Per-frame values handed to every shader
+    struct FrameUniforms {
+        float time = 0.0f;
+        float timeDelta = 0.0f;          // Since the previous frame, for incremental (feedback) effects
+        float pitch = 0.0f;
+        float position = 0.0f;
+        float duration = 1.0f;
+        float features[AudioFeatures::UNIFORM_VEC4S * 4] = {};
+    };
+    // One frame of 'program' into the bound drawable, at the program's scale
+    void drawFrame(const ShaderProgram& program, const FrameUniforms& uniforms, int drawableWidth, int drawableHeight);
+    // Next selectable shader from 'index' in 'direction' (+1/-1), skipping failed and too slow ones
+    int stepProgram(int index, int direction) const;
+    // Only the render thread adds entries (hot reload), under m_programsMutex, and none are
+    // ever removed: pointers stay valid, other threads lock while they index the list
+    std::vector<std::unique_ptr<ShaderProgram>> m_programs;
+    mutable std::mutex m_programsMutex;
+    std::string m_shaderDir;
+    std::unique_ptr<ShaderPreprocessor> m_preprocessor;
+    ShaderWatcher m_watcher;
+    std::atomic<int> m_quality{-1};      // Pinned tier, -1 = auto
+    std::unique_ptr<ShaderProfiles> m_profiles;
+    // Drawn shader being timed; restarts whenever the drawn program object changes
+    struct Measurement {
+        const ShaderProgram* program = nullptr;
+        GLuint id = 0;
+        int frames = 0;
+        float msPerMegapixel = 0.0f;     // Sum over the timed frames
+        bool active = false;
     };
-    std::vector<ShaderProgram> m_programs;
-    int m_currentProgramIndex = 0;
+    Measurement m_measurement;
+    std::atomic<int> m_drawableWidth{0}, m_drawableHeight{0};
+    std::atomic<int> m_currentProgramIndex{0};
+    
+    std::unique_ptr<ProgramCache> m_cache;
+    SDL_Window* m_compileWindow = nullptr;
+    SDL_GLContext m_compileContext = nullptr;
+    std::thread m_compileThread;
+    Uint32 m_initTicks = 0;
 
     std::shared_ptr<FrequencyAnalyzer> m_analyzer;
     AudioPlayer* m_player; // Borrowed pointer 
@@ -47,9 +193,52 @@ private:
     
     SDL_Window* m_window;
     SDL_GLContext m_glContext;
+    std::unique_ptr<HeadlessContext> m_headless;
     
     GLuint m_vbo;
-    GLuint m_spectrumTexture;
+    GLuint m_vao = 0;                // 0 when the driver has no vertex array objects
+    GLuint m_boundProgram = 0;
+    // Persistent analysis textures, re-uploaded only when the analyzer publishes a new frame
+    GLuint m_spectrumTexture = 0;   // u_spectrum: SPECTRUM_BANDS x 1, mix
+    GLuint m_stereoTexture = 0;     // u_spectrumStereo: SPECTRUM_BANDS x 2, rows left/right
+    GLuint m_waveformTexture = 0;   // u_waveform: WAVEFORM_POINTS x 2, rows left/right, 0.5 = silence
+    // u_spectrogram: SPECTRUM_BANDS x SPECTROGRAM_ROWS ring of past mix spectra, one row per new
+    // spectrum frame; u_spectrogramHead is the v of the newest row, v - k / ROWS is k rows older
+    // (the texture repeats vertically, so fract() is optional)
+    GLuint m_spectrogramTexture = 0;
+    int m_spectrogramHead = 0;
+    static const int SPECTRUM_BANDS = 256;
+    static const int SPECTROGRAM_ROWS = 128;
+    static const int SPECTROGRAM_TEXTURE_UNIT = 4;
+    std::vector<uint8_t> m_textureBytes;   // Upload scratch
+    
+    // Reduced-scale rendering, the frame texture stays bound on its own unit
+    GLuint m_fbo = 0;
+    GLuint m_frameTexture = 0;
+    GLuint m_blitProgram = 0;
+    int m_frameWidth = 0, m_frameHeight = 0;
+    std::atomic<int> m_renderWidth{0}, m_renderHeight{0};  // Size the shader last ran at
+    static const int FRAME_TEXTURE_UNIT = 3;
+    static const char* BLIT_SOURCE;
+    GLint m_blitFrameLocation = -1;
+    int m_blitUnit = FRAME_TEXTURE_UNIT;   // Unit u_frame samples: the frame, or the feedback state
+    
+    // State of the drawn '#pragma feedback' shader, cleared when it is switched to;
+    // null without framebuffer support. The previous frame stays bound on its own unit.
+    std::unique_ptr<FeedbackBuffer> m_feedback;
+    const ShaderProgram* m_feedbackOwner = nullptr;
+    // 1x1 transparent black on the unit while there is no state: every frame reads as the first
+    GLuint m_noFeedbackTexture = 0;
+    static const int FEEDBACK_TEXTURE_UNIT = 5;
+    ResolutionController m_resolution;
+    FrameScheduler m_scheduler;
+    
+    // Frame timing, written by the render loop
+    std::atomic<uint64_t> m_statFrames{0};
+    std::atomic<float> m_avgSubmitMs{0.0f};  // Analysis reads, uploads, uniforms and draw call
+    std::atomic<float> m_avgSwapMs{0.0f};    // Buffer swap (vsync wait and GPU)
+    std::atomic<float> m_avgFrameMs{0.0f};   // Interval between frames
+    std::atomic<float> m_avgRenderMs{0.0f};  // Shader pass and upscale, until the GPU is done
     
     static const char* VERTEX_SOURCE;
     // Fragment sources will be loaded internally
@@ -0,0 +1,192 @@
+#include "ShaderVisualizer.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+// Untimed frames per shader before measuring (driver warm-up, first-use compiles)
+static const int WARMUP_FRAMES = 10;
+static const float BENCH_FPS = 60.0f;
+
+// Deterministic stand-in for the analyzer: a 120 BPM kick, a slowly sweeping
+// tone, some hiss and a drifting stereo balance, so every shader sees beats,
+// movement and both channels. Same frame index, same input.
+static void synthesize(int frame, int bands, float* spectra, int points, float* waveform, AudioFeatures& features) {
+    const float pi = 3.14159265f;
+    float t = frame / BENCH_FPS;
+    float beatPhase = std::fmod(t * 2.0f, 1.0f);
+    float kick = std::exp(-beatPhase * 6.0f);
+    float sweep = 0.35f + 0.25f * std::sin(t * 0.7f);
+    float balance = 0.3f * std::sin(t * 1.3f);
+
+    auto clamp01 = [](float v) { return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v); };
+    for (int b = 0; b < bands; ++b) {
+        float x = (float)b / (bands - 1);
+        float tone = (x - sweep) * 40.0f;
+        float hiss = 0.5f + 0.5f * std::sin(b * 12.9898f + frame * 0.37f);
+        float mix = 0.25f * (1.0f - x) + 0.9f * kick * std::exp(-x * 12.0f) + 0.7f * std::exp(-tone * tone) + 0.1f * hiss;
+        spectra[b] = clamp01(mix);
+        spectra[bands + b] = clamp01(mix * (1.0f - balance));
+        spectra[2 * bands + b] = clamp01(mix * (1.0f + balance));
+    }
+    for (int k = 0; k < points; ++k) {
+        float phase = 2.0f * pi * k / points;
+        float body = 0.6f * kick * std::sin(phase * 3.0f);
+        waveform[k] = (body + 0.3f * std::sin(phase * 17.0f + t * 4.0f)) * (1.0f - balance);
+        waveform[points + k] = (body + 0.3f * std::sin(phase * 17.0f + t * 4.0f + 0.8f)) * (1.0f + balance);
+    }
+
+    features.rms = 0.2f + 0.3f * kick;
+    features.peak = std::min(1.0f, features.rms * 1.6f);
+    features.onset = beatPhase < 0.1f ? 1.0f - beatPhase * 10.0f : 0.0f;
+    features.flux = 0.8f * kick;
+    features.bass = kick;
+    features.lowMid = 0.5f + 0.3f * std::sin(t);
+    features.highMid = 0.4f + 0.3f * std::sin(t * 1.7f);
+    features.treble = 0.3f + 0.2f * std::sin(t * 2.3f);
+    features.centroid = 2000.0f + 1000.0f * std::sin(t * 0.7f);
+    features.beatPhase = beatPhase;
+    features.bpm = 120.0f;
+    features.beatConfidence = 0.9f;
+    features.dominantHz = 220.0f + 110.0f * std::sin(t * 0.7f);
+    features.sampleRate = 48000.0f;
+    features.correlation = 0.8f;
+    features.balance = balance;
+    features.width = 0.2f;
+}
+
+// Binary PPM of the current read buffer, top row first
+static bool writePpm(const std::string& path, int width, int height) {
+    std::vector<uint8_t> pixels((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (int y = height - 1; y >= 0; --y) {
+        file.write((const char*)pixels.data() + (size_t)y * width * 3, (std::streamsize)width * 3);
+    }
+    return (bool)file;
+}
+
+int ShaderVisualizer::runBenchmark(const BenchOptions& options) {
+    ShaderVisualizer visualizer(nullptr, nullptr);
+    // Pinned before initRenderer() builds the first shader, so it is built once, at this tier
+    visualizer.setQuality(options.quality);
+    if (!visualizer.initHeadless(options.width, options.height)) return 1;
+    return visualizer.benchmark(options);
+}
+
+bool ShaderVisualizer::initHeadless(int width, int height) {
+    m_initTicks = SDL_GetTicks();
+    m_headless = std::make_unique<HeadlessContext>();
+    if (!m_headless->create(width, height)) return false;
+
+    glewExperimental = GL_TRUE;
+    GLenum glewError = glewInit();
+    // GLX builds of GLEW load the entry points first, then fail to find an X display we do not need
+    if (glewError != GLEW_OK && glewError != GLEW_ERROR_NO_GLX_DISPLAY) {
+        std::cerr << "Error initializing GLEW: " << glewGetErrorString(glewError) << std::endl;
+        return false;
+    }
+    std::cout << "[Bench] OpenGL " << glGetString(GL_VERSION) << " on " << glGetString(GL_RENDERER) << std::endl;
+    return initRenderer(false);
+}
+
+int ShaderVisualizer::benchmark(const BenchOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    // Always full resolution: the numbers are the cost of the shader itself
+    m_resolution.setTargetMs(0.0f);
+
+    std::vector<ShaderProgram*> selected;
+    int failed = 0;
+    for (auto& program : m_programs) {
+        if (!options.shader.empty() && program->name != options.shader) continue;
+        if (program->state == READY) {
+            // Built by initRenderer(); timing it at another tier would be recorded under the wrong one
+            if (program->quality != options.quality) relinkProgram(*program, program->source, options.quality);
+        } else {
+            program->quality = options.quality;
+            buildProgram(*program);
+        }
+        if (program->state == READY && program->quality == options.quality) selected.push_back(program.get());
+        else failed++;
+    }
+    if (selected.empty() && failed == 0) {
+        std::cerr << "[Bench] Shader not found: " << options.shader << std::endl;
+        return 1;
+    }
+    if (!options.dumpDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(options.dumpDir, ec);
+    }
+
+    const int points = FrequencyAnalyzer::WAVEFORM_POINTS;
+    std::vector<float> spectra(3 * SPECTRUM_BANDS), waveform(2 * points), samples;
+    AudioFeatures features;
+    FrameUniforms uniforms;
+    uniforms.duration = 180.0f;
+    uniforms.timeDelta = 1.0f / BENCH_FPS;
+    int frames = std::max(1, options.frames);
+
+    std::cout << "[Bench] " << selected.size() << " shaders, " << options.width << "x" << options.height
+              << ", quality " << options.quality << ", " << frames << " frames each" << std::endl;
+    std::cout << std::left << std::setw(18) << "shader" << std::right << std::setw(10) << "ms/frame"
+              << std::setw(10) << "p95 ms" << std::setw(10) << "max ms" << std::setw(8) << "fps" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::vector<float> silence((size_t)SPECTRUM_BANDS * SPECTROGRAM_ROWS, 0.0f);
+    for (ShaderProgram* program : selected) {
+        samples.clear();
+        // Same history for every shader, whatever ran before it
+        uploadTexture(m_spectrogramTexture, SPECTROGRAM_TEXTURE_UNIT, SPECTRUM_BANDS, SPECTROGRAM_ROWS, silence.data(), 1.0f, 0.0f);
+        m_spectrogramHead = 0;
+        for (int frame = -WARMUP_FRAMES; frame < frames; ++frame) {
+            int index = std::max(0, frame);
+            synthesize(index, SPECTRUM_BANDS, spectra.data(), points, waveform.data(), features);
+            uploadTexture(m_spectrumTexture, 0, SPECTRUM_BANDS, 1, spectra.data(), 1.0f, 0.0f);
+            pushSpectrogramRow(spectra.data());
+            uploadTexture(m_stereoTexture, 1, SPECTRUM_BANDS, 2, spectra.data() + SPECTRUM_BANDS, 1.0f, 0.0f);
+            uploadTexture(m_waveformTexture, 2, points, 2, waveform.data(), 0.5f, 0.5f);
+            features.packUniforms(uniforms.features);
+            uniforms.pitch = features.dominantHz;
+            uniforms.time = index / BENCH_FPS;
+            uniforms.position = uniforms.time;
+
+            // Timed like the live loop (drawFrame plus glFinish), the profile compares the two
+            Clock::time_point start = Clock::now();
+            drawFrame(*program, uniforms, options.width, options.height);
+            glFinish();
+            if (frame >= 0) samples.push_back(std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+        }
+
+        float mean = 0.0f;
+        for (float ms : samples) mean += ms;
+        mean /= samples.size();
+        std::sort(samples.begin(), samples.end());
+        float p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+        // Doubles as a calibration pass for the live visuals, see ShaderProfiles
+        m_profiles->record(program->name, program->quality, program->cacheKey,
+                           mean * 1e6f / ((float)options.width * options.height));
+        std::cout << std::left << std::setw(18) << program->name << std::right << std::setw(10) << mean
+                  << std::setw(10) << p95 << std::setw(10) << samples.back() << std::setw(8)
+                  << std::setprecision(0) << 1000.0f / mean << std::setprecision(2) << std::endl;
+
+        if (!options.dumpDir.empty()) {
+            std::string path = options.dumpDir + "/" + program->name + ".ppm";
+            if (!writePpm(path, options.width, options.height)) {
+                std::cerr << "[Bench] Cannot write " << path << std::endl;
+            }
+        }
+    }
+
+    if (!selected.empty() && m_profiles->save()) std::cout << "[Bench] Profiles saved to " << m_profiles->path() << std::endl;
+    if (failed > 0) std::cerr << "[Bench] " << failed << " shader(s) failed to build" << std::endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#include "ShaderWatcher.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+ShaderWatcher::~ShaderWatcher() {
+    stop();
+}
+
+bool ShaderWatcher::start(const std::string& directory) {
+    stop();
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        std::cerr << "[ShaderWatcher] inotify unavailable: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "[ShaderWatcher] Cannot watch " << directory << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void ShaderWatcher::stop() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+std::vector<std::string> ShaderWatcher::poll() {
+    std::vector<std::string> files;
+    if (m_fd < 0) return files;
+
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;  // EAGAIN: nothing (more) pending
+        for (char* p = buffer; p < buffer + length;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len == 0) continue;
+            std::string file(event->name);
+            size_t dot = file.rfind('.');
+            std::string extension = dot == std::string::npos ? std::string() : file.substr(dot);
+            if (extension != ".frag" && extension != ".glsl") continue;
+            if (std::find(files.begin(), files.end(), file) == files.end()) files.push_back(file);
+        }
+    }
+    return files;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * ShaderWatcher - Reports shaders (.frag) and includes (.glsl) written or moved into a directory
+ *
+ * Wraps a non-blocking inotify descriptor: poll() is one read() that
+ * returns immediately, cheap enough to call once per frame. Editors that
+ * save through a temporary file and a rename are covered by IN_MOVED_TO,
+ * in-place writes by IN_CLOSE_WRITE. Deletions are ignored, so a shader
+ * that disappears keeps running until the visuals restart.
+ */
+class ShaderWatcher {
+public:
+    ShaderWatcher() = default;
+    ~ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    bool start(const std::string& directory);
+    void stop();
+
+    // File names changed since the last call, each once
+    std::vector<std::string> poll();
+
+private:
+    int m_fd = -1;
+};
@@ -0,0 +1,315 @@
+#include "TrackAnalysis.hpp"
+#include "RealFft.hpp"
+#include "BandMapper.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+// Serialized layout (host byte order, like the PIRA header):
+// [0-3]   Magic "ABAN"
+// [4]     Format version (1)
+// [5]     Bands
+// [6]     Feature bytes per frame
+// [7]     Reserved
+// [8-11]  Sample rate
+// [12-15] Hop size (frames)
+// [16-19] Frame count
+// [20-23] Beat count
+// [24-27] Waveform points
+// [28-31] Waveform points per second
+// [32-35] BPM (float)
+// [36-39] Beat confidence (float)
+// [40-43] Loudness, dBFS (float)
+// Frames (bands + features), beats (uint32 sample positions), waveform bytes
+static const char MAGIC[4] = { 'A', 'B', 'A', 'N' };
+static const uint8_t FORMAT_VERSION = 1;
+static const size_t HEADER_BYTES = 44;
+static const float LEVEL_FLOOR_DB = -96.0f;
+
+static uint8_t quantize(float value) {
+    return (uint8_t)std::lround(std::min(1.0f, std::max(0.0f, value)) * 255.0f);
+}
+
+static uint8_t quantizeDb(float linear) {
+    if (linear <= 0.0f) return 0;
+    float db = 20.0f * std::log10(linear);
+    return quantize((db - LEVEL_FLOOR_DB) / -LEVEL_FLOOR_DB);
+}
+
+static float dequantizeDb(float byte) {
+    if (byte <= 0.0f) return 0.0f;
+    return std::pow(10.0f, (byte / 255.0f * -LEVEL_FLOOR_DB + LEVEL_FLOOR_DB) / 20.0f);
+}
+
+std::shared_ptr<TrackAnalysis> TrackAnalysis::analyze(const int16_t* pcm, size_t frames, unsigned channels, unsigned sampleRate) {
+    if (!pcm || frames == 0 || channels == 0 || sampleRate == 0) return nullptr;
+
+    // Mono float copy, padded by half a window on each side so frames can be centred
+    const size_t pad = FFT_SIZE / 2;
+    std::vector<float> mono(frames + 2 * pad, 0.0f);
+    const float gain = 1.0f / (32768.0f * channels);
+    double sumSquares = 0.0;
+    for (size_t i = 0; i < frames; ++i) {
+        int sum = 0;
+        for (unsigned c = 0; c < channels; ++c) sum += pcm[i * channels + c];
+        mono[pad + i] = sum * gain;
+    }
+
+    auto analysis = std::make_shared<TrackAnalysis>();
+    analysis->m_sampleRate = sampleRate;
+    analysis->m_frameCount = frames / HOP_SIZE + 1;
+    analysis->m_frames.assign(analysis->m_frameCount * FRAME_BYTES, 0);
+
+    RealFft fft(FFT_SIZE);
+    BandMapper mapper;
+    mapper.build(BandMapper::Layout::Log, BANDS, FFT_SIZE, (float)sampleRate);
+    FeatureExtractor extractor;
+    extractor.reset(FFT_SIZE, HOP_SIZE, (float)sampleRate);
+
+    std::vector<float> magnitudes(FFT_SIZE / 2), bands(BANDS), onset(analysis->m_frameCount), tempos;
+    AudioFeatures features;
+    size_t gatedFrames = 0;
+    for (size_t f = 0; f < analysis->m_frameCount; ++f) {
+        // Window centred on f * HOP_SIZE; the hop slice around the centre feeds the level features
+        const float* window = mono.data() + f * HOP_SIZE;
+        fft.magnitudes(window, magnitudes.data());
+        extractor.process(window + pad - HOP_SIZE / 2, HOP_SIZE, magnitudes.data(), features);
+
+        float maxVal = 0.0001f;
+        for (float mag : magnitudes) maxVal = std::max(maxVal, mag);
+        for (float& mag : magnitudes) mag /= maxVal;
+        mapper.map(magnitudes.data(), bands.data());
+
+        uint8_t* out = &analysis->m_frames[f * FRAME_BYTES];
+        for (int b = 0; b < BANDS; ++b) out[b] = quantize(bands[b]);
+        uint8_t* feat = out + BANDS;
+        feat[RMS] = quantizeDb(features.rms);
+        feat[PEAK] = quantizeDb(features.peak);
+        feat[ONSET] = quantize(features.onset);
+        feat[FLUX] = quantize(features.flux);
+        feat[BASS] = quantize(features.bass);
+        feat[LOW_MID] = quantize(features.lowMid);
+        feat[HIGH_MID] = quantize(features.highMid);
+        feat[TREBLE] = quantize(features.treble);
+        uint16_t centroid = (uint16_t)std::min(65535.0f, features.centroid);
+        uint16_t dominant = (uint16_t)std::min(65535.0f, features.dominantHz);
+        feat[CENTROID_LO] = centroid & 0xff;
+        feat[CENTROID_HI] = centroid >> 8;
+        feat[DOMINANT_LO] = dominant & 0xff;
+        feat[DOMINANT_HI] = dominant >> 8;
+
+        onset[f] = features.onset;
+        if (features.bpm > 0.0f && features.beatConfidence >= 0.2f) tempos.push_back(features.bpm);
+
+        // Loudness: mean square of the frames above an absolute -70 dBFS gate
+        if (features.rms > 0.000316f) {
+            sumSquares += (double)features.rms * features.rms;
+            gatedFrames++;
+        }
+    }
+    if (gatedFrames > 0) {
+        analysis->m_loudnessDb = (float)(10.0 * std::log10(sumSquares / gatedFrames));
+    }
+
+    // One tempo for the track: the median of the confident running estimates
+    if (!tempos.empty()) {
+        std::nth_element(tempos.begin(), tempos.begin() + tempos.size() / 2, tempos.end());
+        analysis->m_bpm = tempos[tempos.size() / 2];
+        analysis->m_beatConfidence = (float)tempos.size() / analysis->m_frameCount;
+        analysis->trackBeats(onset, 60.0f / analysis->m_bpm * sampleRate / HOP_SIZE);
+    }
+
+    // Peak overview
+    size_t step = std::max<size_t>(1, sampleRate / WAVEFORM_RATE);
+    for (size_t start = 0; start < frames; start += step) {
+        float peak = 0.0f;
+        for (size_t i = start; i < std::min(frames, start + step); ++i) peak = std::max(peak, std::fabs(mono[pad + i]));
+        analysis->m_waveform.push_back(quantize(peak));
+    }
+    return analysis;
+}
+
+// Dynamic-programming beat tracking (Ellis 2007): each frame's score is its
+// onset strength plus the best predecessor score, penalised by how far the
+// interval is from the tempo period. Backtracking from the best final beat
+// gives beats that follow the onsets while keeping a steady pulse.
+void TrackAnalysis::trackBeats(const std::vector<float>& onset, float period) {
+    const int n = (int)onset.size();
+    if (period < 2.0f || n < (int)(period * 4)) return;
+
+    float mean = 0.0f, var = 0.0f;
+    for (float v : onset) mean += v;
+    mean /= n;
+    for (float v : onset) var += (v - mean) * (v - mean);
+    float norm = var > 0.0f ? 1.0f / std::sqrt(var / n) : 1.0f;
+
+    const float tightness = 100.0f;
+    std::vector<float> score(n);
+    std::vector<int> backlink(n, -1);
+    for (int t = 0; t < n; ++t) {
+        float local = onset[t] * norm;
+        int first = t - (int)std::lround(2.0f * period);
+        int last = t - (int)std::lround(period * 0.5f);
+        float best = 0.0f;
+        int link = -1;
+        for (int p = std::max(0, first); p <= last; ++p) {
+            float ratio = std::log((t - p) / period);
+            float candidate = score[p] - tightness * ratio * ratio;
+            if (link < 0 || candidate > best) {
+                best = candidate;
+                link = p;
+            }
+        }
+        score[t] = local + (link >= 0 ? std::max(0.0f, best) : 0.0f);
+        backlink[t] = (link >= 0 && best > 0.0f) ? link : -1;
+    }
+
+    // Last beat: best score within the final period
+    int end = n - 1;
+    for (int t = std::max(0, n - (int)period); t < n; ++t) {
+        if (score[t] > score[end]) end = t;
+    }
+    std::vector<float> beats;
+    for (int t = end; t >= 0; t = backlink[t]) {
+        beats.push_back((float)t * HOP_SIZE / m_sampleRate);
+    }
+    std::reverse(beats.begin(), beats.end());
+    m_beats.swap(beats);
+}
+
+std::vector<unsigned char> TrackAnalysis::serialize() const {
+    std::vector<unsigned char> out(HEADER_BYTES, 0);
+    auto put32 = [&](size_t offset, uint32_t value) { std::memcpy(&out[offset], &value, 4); };
+    auto putFloat = [&](size_t offset, float value) { std::memcpy(&out[offset], &value, 4); };
+
+    std::memcpy(&out[0], MAGIC, 4);
+    out[4] = FORMAT_VERSION;
+    out[5] = BANDS;
+    out[6] = FEATURE_BYTES;
+    put32(8, m_sampleRate);
+    put32(12, HOP_SIZE);
+    put32(16, (uint32_t)m_frameCount);
+    put32(20, (uint32_t)m_beats.size());
+    put32(24, (uint32_t)m_waveform.size());
+    put32(28, WAVEFORM_RATE);
+    putFloat(32, m_bpm);
+    putFloat(36, m_beatConfidence);
+    putFloat(40, m_loudnessDb);
+
+    out.insert(out.end(), m_frames.begin(), m_frames.end());
+    for (float beat : m_beats) {
+        uint32_t position = (uint32_t)std::lround(beat * m_sampleRate);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&position);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+    out.insert(out.end(), m_waveform.begin(), m_waveform.end());
+    return out;
+}
+
+std::shared_ptr<TrackAnalysis> TrackAnalysis::parse(const std::vector<unsigned char>& data) {
+    if (data.size() < HEADER_BYTES || std::memcmp(data.data(), MAGIC, 4) != 0) return nullptr;
+    auto get32 = [&](size_t offset) { uint32_t value; std::memcpy(&value, &data[offset], 4); return value; };
+    auto getFloat = [&](size_t offset) { float value; std::memcpy(&value, &data[offset], 4); return value; };
+
+    // Layout is fixed per format version; anything else came from a newer encrypt_util
+    if (data[4] != FORMAT_VERSION || data[5] != BANDS || data[6] != FEATURE_BYTES ||
+        get32(12) != HOP_SIZE || get32(28) != WAVEFORM_RATE || get32(8) == 0) {
+        return nullptr;
+    }
+
+    auto analysis = std::make_shared<TrackAnalysis>();
+    analysis->m_sampleRate = get32(8);
+    analysis->m_frameCount = get32(16);
+    size_t beatCount = get32(20);
+    size_t waveformCount = get32(24);
+    analysis->m_bpm = getFloat(32);
+    analysis->m_beatConfidence = getFloat(36);
+    analysis->m_loudnessDb = getFloat(40);
+
+    size_t frameBytes = analysis->m_frameCount * FRAME_BYTES;
+    if (analysis->m_frameCount == 0 || data.size() != HEADER_BYTES + frameBytes + beatCount * 4 + waveformCount) {
+        return nullptr;
+    }
+
+    const unsigned char* p = data.data() + HEADER_BYTES;
+    analysis->m_frames.assign(p, p + frameBytes);
+    p += frameBytes;
+    analysis->m_beats.resize(beatCount);
+    for (size_t i = 0; i < beatCount; ++i, p += 4) {
+        uint32_t position;
+        std::memcpy(&position, p, 4);
+        analysis->m_beats[i] = (float)position / analysis->m_sampleRate;
+    }
+    analysis->m_waveform.assign(p, p + waveformCount);
+    return analysis;
+}
+
+double TrackAnalysis::duration() const {
+    return (double)(m_frameCount - 1) * HOP_SIZE / m_sampleRate;
+}
+
+void TrackAnalysis::spectrumAt(double seconds, float* bands) const {
+    double x = std::max(0.0, seconds * m_sampleRate / HOP_SIZE);
+    size_t i0 = std::min((size_t)x, m_frameCount - 1);
+    size_t i1 = std::min(i0 + 1, m_frameCount - 1);
+    float frac = (float)(x - i0);
+    if (i0 == i1) frac = 0.0f;
+
+    const uint8_t* a = &m_frames[i0 * FRAME_BYTES];
+    const uint8_t* b = &m_frames[i1 * FRAME_BYTES];
+    for (int k = 0; k < BANDS; ++k) {
+        bands[k] = (a[k] + (b[k] - a[k]) * frac) * (1.0f / 255.0f);
+    }
+}
+
+AudioFeatures TrackAnalysis::featuresAt(double seconds) const {
+    double x = std::max(0.0, seconds * m_sampleRate / HOP_SIZE);
+    size_t i0 = std::min((size_t)x, m_frameCount - 1);
+    size_t i1 = std::min(i0 + 1, m_frameCount - 1);
+    float frac = (i0 == i1) ? 0.0f : (float)(x - i0);
+    auto lerp = [&](int byte) {
+        float a = frameValue(i0, BANDS + byte), b = frameValue(i1, BANDS + byte);
+        return a + (b - a) * frac;
+    };
+    auto lerp16 = [&](int lo, int hi) {
+        float a = frameValue(i0, BANDS + lo) + 256.0f * frameValue(i0, BANDS + hi);
+        float b = frameValue(i1, BANDS + lo) + 256.0f * frameValue(i1, BANDS + hi);
+        return a + (b - a) * frac;
+    };
+
+    AudioFeatures f;
+    f.rms = dequantizeDb(lerp(RMS));
+    f.peak = dequantizeDb(lerp(PEAK));
+    f.onset = lerp(ONSET) / 255.0f;
+    f.flux = lerp(FLUX) / 255.0f;
+    f.bass = lerp(BASS) / 255.0f;
+    f.lowMid = lerp(LOW_MID) / 255.0f;
+    f.highMid = lerp(HIGH_MID) / 255.0f;
+    f.treble = lerp(TREBLE) / 255.0f;
+    f.centroid = lerp16(CENTROID_LO, CENTROID_HI);
+    f.dominantHz = frameValue(frac < 0.5f ? i0 : i1, BANDS + DOMINANT_LO) +
+                   256.0f * frameValue(frac < 0.5f ? i0 : i1, BANDS + DOMINANT_HI);
+    f.sampleRate = (float)m_sampleRate;
+    f.bpm = m_bpm;
+    f.beatConfidence = m_beatConfidence;
+
+    // Phase between the surrounding beats, so tempo drift is followed exactly
+    auto next = std::upper_bound(m_beats.begin(), m_beats.end(), (float)seconds);
+    if (next != m_beats.begin() && next != m_beats.end()) {
+        float prev = *(next - 1);
+        f.beatPhase = ((float)seconds - prev) / (*next - prev);
+    }
+    return f;
+}
+
+std::string TrackAnalysis::describe() const {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << m_frameCount << " frames (" << duration() << " s, " << (float)m_sampleRate / HOP_SIZE << "/s), "
+       << BANDS << " bands, ";
+    if (m_bpm > 0.0f) ss << m_bpm << " BPM, " << m_beats.size() << " beats, ";
+    ss << "loudness " << m_loudnessDb << " dBFS";
+    return ss.str();
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "FeatureExtractor.hpp"
+
+/**
+ * TrackAnalysis - Spectrum and feature stream computed once per track
+ *
+ * encrypt_util --analysis runs this over the decoded track and embeds the
+ * serialized result in the PIRA file. The player replays it against the
+ * playback clock instead of running the FFT on the device.
+ *
+ * Frames are centred on multiples of the hop, so replay has no analysis
+ * latency. Each frame holds BANDS log-spaced spectrum bands and the level
+ * features, quantized to 8 bits. Beats come from dynamic-programming beat
+ * tracking over the whole onset envelope. A peak overview of the waveform
+ * (WAVEFORM_RATE points per second) and the gated loudness of the track
+ * are stored alongside.
+ */
+class TrackAnalysis {
+public:
+    static const int BANDS = 64;
+    static const int FFT_SIZE = 2048;
+    static const int HOP_SIZE = 1024;
+    static const int WAVEFORM_RATE = 20;
+
+    // Offline: interleaved s16 PCM at the track's native rate
+    static std::shared_ptr<TrackAnalysis> analyze(const int16_t* pcm, size_t frames, unsigned channels, unsigned sampleRate);
+
+    std::vector<unsigned char> serialize() const;
+    static std::shared_ptr<TrackAnalysis> parse(const std::vector<unsigned char>& data);
+
+    // Replay, interpolated between the two nearest frames
+    void spectrumAt(double seconds, float* bands) const;   // BANDS values, 0..1
+    AudioFeatures featuresAt(double seconds) const;
+
+    double duration() const;
+    size_t frameCount() const { return m_frameCount; }
+    float bpm() const { return m_bpm; }
+    float loudnessDb() const { return m_loudnessDb; }
+    const std::vector<float>& beats() const { return m_beats; }          // Seconds
+    const std::vector<uint8_t>& waveform() const { return m_waveform; }  // Peak, 255 = full scale
+    std::string describe() const;
+
+private:
+    // Per frame, after the bands
+    enum FeatureByte { RMS, PEAK, ONSET, FLUX, BASS, LOW_MID, HIGH_MID, TREBLE,
+                       CENTROID_LO, CENTROID_HI, DOMINANT_LO, DOMINANT_HI, FEATURE_BYTES };
+    static const int FRAME_BYTES = BANDS + FEATURE_BYTES;
+
+    void trackBeats(const std::vector<float>& onset, float period);
+    float frameValue(size_t frame, int byte) const { return m_frames[frame * FRAME_BYTES + byte]; }
+
+    unsigned m_sampleRate = 0;
+    size_t m_frameCount = 0;
+    std::vector<uint8_t> m_frames;
+    std::vector<float> m_beats;
+    std::vector<uint8_t> m_waveform;
+    float m_bpm = 0.0f;
+    float m_beatConfidence = 0.0f;
+    float m_loudnessDb = -96.0f;
+};
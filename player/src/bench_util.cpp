@@ -0,0 +1,457 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <complex>
+#include <algorithm>
+#include <cstdlib>
+#include "../include/miniaudio.h"
+#include "AbbyCrypt.hpp"
+#include "PcmDecoder.hpp"
+#include "AudioDsp.hpp"
+#include "RealFft.hpp"
+#include "BandMapper.hpp"
+
+// abby-bench - CPU cost of individual pipeline stages, no audio device needed.
+// All timings are thread CPU time, which is also the best battery proxy we
+// have on the device (the rest of the system idles while we don't run).
+
+static double cpuMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const ma_uint32 BLOCK_FRAMES = 1024; // Typical device period
+
+struct StageResult {
+    std::string name;
+    size_t fileBytes = 0;
+    double decryptMs = 0.0;
+    double decodeMs = 0.0;
+    double audioSeconds = 0.0;
+};
+
+static void printResult(const StageResult& r) {
+    double total = r.decryptMs + r.decodeMs;
+    double perSec = (r.audioSeconds > 0) ? total / r.audioSeconds : 0.0;
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << std::left << std::setw(6) << r.name << std::right
+              << " file " << std::setw(9) << r.fileBytes / 1024 << " KiB"
+              << "  decrypt " << std::setw(8) << r.decryptMs << " ms"
+              << "  decode " << std::setw(8) << r.decodeMs << " ms"
+              << "  => " << std::setw(6) << perSec << " ms CPU / s audio ("
+              << perSec / 10.0 << "% of one core, "
+              << perSec * 3.6 << " CPU-s per hour)" << std::endl;
+}
+
+// Decrypts every chunk of a PIRA file, returning the plaintext
+static std::vector<unsigned char> decryptAll(const std::string& path, const std::string& serial, double& ms) {
+    std::vector<unsigned char> out;
+    if (!Abby::AbbyCrypt::openEncryptedFile(path, serial)) return out;
+
+    double start = cpuMs();
+    size_t total = Abby::AbbyCrypt::getTotalChunks();
+    for (size_t i = 0; i < total; ++i) {
+        std::vector<unsigned char> chunk = Abby::AbbyCrypt::decryptNextChunk();
+        if (chunk.empty()) break;
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+    ms = cpuMs() - start;
+
+    Abby::AbbyCrypt::closeEncryptedFile();
+    return out;
+}
+
+static size_t fileSize(const std::string& path) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return f ? (size_t)f.tellg() : 0;
+}
+
+// MP3 (PIRA v2) versus raw PCM (PIRA v3) playback cost
+static int benchDecode(const std::string& input) {
+    std::string serial = Abby::AbbyCrypt::getHardwareSerial();
+    const std::string encodedPath = "/tmp/abby-bench-encoded.pira";
+    const std::string pcmPath = "/tmp/abby-bench-pcm.pira";
+
+    std::vector<unsigned char> pcm;
+    unsigned channels = 0, sampleRate = 0;
+    if (!Abby::AbbyCrypt::encryptTrackFile(input, encodedPath, serial) ||
+        !PcmDecoder::decodeFile(input, pcm, channels, sampleRate) ||
+        !Abby::AbbyCrypt::encryptPcmTrack(pcm, channels, sampleRate, pcmPath, serial)) {
+        std::cerr << "Failed to prepare benchmark files" << std::endl;
+        return 1;
+    }
+    const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(ma_format_s16, channels);
+    const double audioSeconds = (double)(pcm.size() / bytesPerFrame) / sampleRate;
+    pcm.clear();
+
+    // Compressed path: decrypt + ma_decoder in device-sized blocks (as data_callback does)
+    StageResult encoded;
+    encoded.name = "mp3";
+    encoded.fileBytes = fileSize(encodedPath);
+    encoded.audioSeconds = audioSeconds;
+    std::vector<unsigned char> stream = decryptAll(encodedPath, serial, encoded.decryptMs);
+    {
+        ma_decoder_config config = ma_decoder_config_init_default();
+        ma_decoder decoder;
+        if (ma_decoder_init_memory(stream.data(), stream.size(), &config, &decoder) != MA_SUCCESS) {
+            std::cerr << "Failed to init decoder" << std::endl;
+            return 1;
+        }
+        std::vector<unsigned char> block(BLOCK_FRAMES * ma_get_bytes_per_frame(decoder.outputFormat, decoder.outputChannels));
+        double start = cpuMs();
+        for (;;) {
+            ma_uint64 framesRead = 0;
+            if (ma_decoder_read_pcm_frames(&decoder, block.data(), BLOCK_FRAMES, &framesRead) != MA_SUCCESS || framesRead == 0) break;
+        }
+        encoded.decodeMs = cpuMs() - start;
+        ma_decoder_uninit(&decoder);
+    }
+
+    // Raw PCM path: decrypt + block copy into the device buffer
+    StageResult raw;
+    raw.name = "pcm";
+    raw.fileBytes = fileSize(pcmPath);
+    raw.audioSeconds = audioSeconds;
+    stream = decryptAll(pcmPath, serial, raw.decryptMs);
+    {
+        std::vector<unsigned char> block(BLOCK_FRAMES * bytesPerFrame);
+        double start = cpuMs();
+        for (size_t pos = 0; pos < stream.size(); pos += block.size()) {
+            size_t n = std::min(block.size(), stream.size() - pos);
+            std::memcpy(block.data(), stream.data() + pos, n);
+        }
+        raw.decodeMs = cpuMs() - start;
+    }
+
+    std::remove(encodedPath.c_str());
+    std::remove(pcmPath.c_str());
+
+    std::cout << "\n[decode] " << input << " (" << std::fixed << std::setprecision(1) << audioSeconds
+              << " s, " << channels << "ch @ " << sampleRate << "Hz)" << std::endl;
+    printResult(encoded);
+    printResult(raw);
+    return 0;
+}
+
+// Reads a whole file into memory
+static std::vector<unsigned char> readFile(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+}
+
+static void printPerFrame(const char* stage, double ms, ma_uint64 frames) {
+    std::cout << "  " << std::left << std::setw(34) << stage << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << (frames > 0 ? ms * 1e6 / frames : 0.0) << " ns/frame" << std::endl;
+}
+
+// Decodes the whole track in device-sized blocks, returning the PCM and CPU ms
+static std::vector<unsigned char> decodeBlocks(const std::vector<unsigned char>& file, ma_format format,
+                                               ma_uint32& channels, ma_uint32& sampleRate, double& ms) {
+    std::vector<unsigned char> pcm;
+    ma_decoder_config config = ma_decoder_config_init(format, 0, 0);
+    ma_decoder decoder;
+    if (ma_decoder_init_memory(file.data(), file.size(), &config, &decoder) != MA_SUCCESS) return pcm;
+
+    channels = decoder.outputChannels;
+    sampleRate = decoder.outputSampleRate;
+    ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(format, channels);
+    std::vector<unsigned char> block(BLOCK_FRAMES * bytesPerFrame);
+
+    double start = cpuMs();
+    for (;;) {
+        ma_uint64 framesRead = 0;
+        if (ma_decoder_read_pcm_frames(&decoder, block.data(), BLOCK_FRAMES, &framesRead) != MA_SUCCESS || framesRead == 0) break;
+        pcm.insert(pcm.end(), block.begin(), block.begin() + framesRead * bytesPerFrame);
+    }
+    ms = cpuMs() - start;
+    ma_decoder_uninit(&decoder);
+    return pcm;
+}
+
+// Per-frame cost of every conversion stage between the decoder and the analyzer
+static int benchConvert(const std::string& input) {
+    std::vector<unsigned char> file = readFile(input);
+    ma_uint32 channels = 0, sampleRate = 0;
+    double f32Ms = 0.0, s16Ms = 0.0;
+
+    std::vector<unsigned char> f32 = decodeBlocks(file, ma_format_f32, channels, sampleRate, f32Ms);
+    std::vector<unsigned char> s16 = decodeBlocks(file, ma_format_s16, channels, sampleRate, s16Ms);
+    if (f32.empty() || s16.empty()) {
+        std::cerr << "Failed to decode " << input << std::endl;
+        return 1;
+    }
+    const ma_uint64 frames = s16.size() / ma_get_bytes_per_frame(ma_format_s16, channels);
+
+    std::cout << "\n[convert] " << input << " (" << frames << " frames, " << channels << "ch @ " << sampleRate << "Hz)" << std::endl;
+    printPerFrame("decode -> f32 (old default)", f32Ms, frames);
+    printPerFrame("decode -> s16 (negotiated)", s16Ms, frames);
+
+    // Device-side format conversion that s16 negotiation avoids
+    {
+        std::vector<unsigned char> out(BLOCK_FRAMES * channels * sizeof(int16_t));
+        size_t blockBytes = BLOCK_FRAMES * channels * sizeof(float);
+        double start = cpuMs();
+        for (size_t pos = 0; pos < f32.size(); pos += blockBytes) {
+            size_t n = std::min(blockBytes, f32.size() - pos) / sizeof(float);
+            ma_pcm_convert(out.data(), ma_format_s16, f32.data() + pos, ma_format_f32, n, ma_dither_mode_none);
+        }
+        printPerFrame("f32 -> s16 device conversion", cpuMs() - start, frames);
+    }
+
+    // Resampling to the other common hardware rate, per device-class quality
+    ma_uint32 targetRate = (sampleRate == 48000) ? 44100 : 48000;
+    const ma_uint32 orders[] = { 0, 4, MA_MAX_FILTER_ORDER };
+    for (ma_uint32 order : orders) {
+        ma_resampler_config config = ma_resampler_config_init(ma_format_s16, channels, sampleRate, targetRate, ma_resample_algorithm_linear);
+        config.linear.lpfOrder = order;
+        ma_resampler resampler;
+        if (ma_resampler_init(&config, NULL, &resampler) != MA_SUCCESS) continue;
+
+        std::vector<int16_t> out(BLOCK_FRAMES * 2 * channels);
+        const int16_t* in = (const int16_t*)s16.data();
+        ma_uint64 remaining = frames;
+        double start = cpuMs();
+        while (remaining > 0) {
+            ma_uint64 frameCountIn = std::min<ma_uint64>(remaining, BLOCK_FRAMES);
+            ma_uint64 frameCountOut = BLOCK_FRAMES * 2;
+            ma_resampler_process_pcm_frames(&resampler, in, &frameCountIn, out.data(), &frameCountOut);
+            if (frameCountIn == 0) break;
+            in += frameCountIn * channels;
+            remaining -= frameCountIn;
+        }
+        std::string label = "resample s16 " + std::to_string(sampleRate) + "->" + std::to_string(targetRate) + " lpf" + std::to_string(order);
+        printPerFrame(label.c_str(), cpuMs() - start, frames);
+        ma_resampler_uninit(&resampler, NULL);
+    }
+
+    // Analyzer input conversion (s16 -> float), as done in data_callback
+    {
+        float block[256];
+        const int16_t* in = (const int16_t*)s16.data();
+        size_t samples = frames * channels;
+        volatile float sink = 0.0f;
+        double start = cpuMs();
+        for (size_t pos = 0; pos < samples; pos += 256) {
+            size_t n = std::min<size_t>(256, samples - pos);
+            for (size_t i = 0; i < n; ++i) block[i] = in[pos + i] * (1.0f / 32768.0f);
+            sink = sink + block[0];
+        }
+        printPerFrame("s16 -> float analyzer tap", cpuMs() - start, frames);
+    }
+    return 0;
+}
+
+// Per-block cost of the DSP stage for each EQ size, s16 stereo like the device
+static int benchDsp() {
+    const ma_uint32 channels = 2, sampleRate = 48000, blocks = 2000;
+    const ma_uint32 blockFrames = AudioDsp::MAX_BLOCK_FRAMES;
+    std::vector<int16_t> block(blockFrames * channels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = (int16_t)(8000.0 * std::sin(i * 0.01) + (int)(i * 7919 % 2000) - 1000);
+    }
+    double budgetUs = blockFrames * 1e6 / sampleRate;
+
+    std::cout << "\n[dsp] " << blockFrames << " frames/block, " << channels << "ch s16 @ " << sampleRate
+              << "Hz (budget " << std::fixed << std::setprecision(0) << budgetUs << " us/block)" << std::endl;
+
+    const int bandCounts[] = { 0, 1, 4, AudioDsp::MAX_BANDS };
+    for (int bands : bandCounts) {
+        for (int ramping = 0; ramping <= 1; ++ramping) {
+            AudioDsp dsp;
+            dsp.setVolume(0.8f);
+            for (int b = 0; b < bands; ++b) dsp.setBand(b, 60.0f * (1 << b), 3.0f, 1.0f);
+            dsp.configure(ma_format_s16, channels, sampleRate);
+
+            std::vector<int16_t> work(block);
+            double start = cpuMs();
+            for (ma_uint32 i = 0; i < blocks; ++i) {
+                // Ramping: a volume change every block keeps the ramp path hot
+                if (ramping) dsp.setVolume((i & 1) ? 0.5f : 0.8f);
+                std::memcpy(work.data(), block.data(), block.size() * sizeof(int16_t));
+                dsp.process(work.data(), blockFrames);
+            }
+            double us = (cpuMs() - start) * 1000.0 / blocks;
+            std::cout << "  eq " << bands << " band(s)" << (ramping ? ", ramping " : ", steady  ")
+                      << std::setprecision(2) << std::setw(8) << us << " us/block ("
+                      << std::setprecision(3) << us / budgetUs * 100.0 << "% of real time)" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// The analyzer's original transform, kept here as the baseline: recursive
+// Cooley-Tukey allocating at every level, std::polar per butterfly and the
+// Hann window recomputed with cos() on every call.
+static void legacyFft(std::vector<std::complex<float>>& x) {
+    const float PI = 3.141592653589793238460f;
+    int n = x.size();
+    if (n <= 1) return;
+
+    std::vector<std::complex<float>> even(n / 2), odd(n / 2);
+    for (int i = 0; i < n / 2; ++i) {
+        even[i] = x[2 * i];
+        odd[i] = x[2 * i + 1];
+    }
+
+    legacyFft(even);
+    legacyFft(odd);
+
+    for (int k = 0; k < n / 2; ++k) {
+        std::complex<float> t = std::polar(1.0f, -2.0f * PI * k / n) * odd[k];
+        x[k] = even[k] + t;
+        x[k + n / 2] = even[k] - t;
+    }
+}
+
+static void legacyMagnitudes(const float* input, int size, float* out) {
+    const float PI = 3.141592653589793238460f;
+    std::vector<std::complex<float>> data(size);
+    for (int i = 0; i < size; ++i) {
+        float window = 0.5f * (1.0f - cos(2.0f * PI * i / (size - 1)));
+        data[i] = std::complex<float>(input[i] * window, 0.0f);
+    }
+    legacyFft(data);
+    for (int i = 0; i < size / 2; ++i) out[i] = std::abs(data[i]);
+}
+
+// Legacy recursive FFT vs RealFft (scalar and SIMD) per transform
+static int benchFft(int onlySize) {
+    std::cout << "\n[fft] windowed magnitudes per transform, SIMD " << RealFft::simdName()
+              << " (compile-time), " << (RealFft::simdSupported() ? "available" : "not available")
+              << " on this CPU" << std::endl;
+
+    for (int size = RealFft::MIN_SIZE; size <= RealFft::MAX_SIZE; size <<= 1) {
+        if (onlySize > 0 && size != onlySize) continue;
+
+        std::vector<float> input(size), ref(size / 2), out(size / 2);
+        for (int i = 0; i < size; ++i) {
+            input[i] = 0.5f * std::sin(i * 0.05f) + 0.25f * std::sin(i * 0.31f) + (float)((i * 7919) % 200 - 100) / 1000.0f;
+        }
+        int iterations = (int)(4000000 / size);
+
+        double start = cpuMs();
+        for (int i = 0; i < iterations; ++i) legacyMagnitudes(input.data(), size, ref.data());
+        double legacyUs = (cpuMs() - start) * 1000.0 / iterations;
+
+        std::cout << std::fixed << "  N=" << std::setw(5) << size << "  legacy " << std::setprecision(2)
+                  << std::setw(8) << legacyUs << " us";
+
+        const RealFft::Kernel kernels[] = { RealFft::Kernel::Scalar, RealFft::Kernel::Simd };
+        for (RealFft::Kernel kernel : kernels) {
+            if (kernel == RealFft::Kernel::Simd && !RealFft::simdSupported()) continue;
+            RealFft fft(size, kernel);
+
+            start = cpuMs();
+            for (int i = 0; i < iterations * 10; ++i) fft.magnitudes(input.data(), out.data());
+            double us = (cpuMs() - start) * 1000.0 / (iterations * 10);
+
+            // Relative to the strongest bin, so the error is comparable across sizes
+            float peak = 0.0f, maxErr = 0.0f;
+            for (int k = 0; k < size / 2; ++k) peak = std::max(peak, ref[k]);
+            for (int k = 0; k < size / 2; ++k) maxErr = std::max(maxErr, std::fabs(out[k] - ref[k]));
+
+            std::cout << "  " << fft.kernelName() << " " << std::setw(7) << us << " us ("
+                      << std::setprecision(1) << legacyUs / us << "x, err " << std::scientific
+                      << std::setprecision(1) << maxErr / peak << std::fixed << std::setprecision(2) << ")";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// Old per-call linear averaging (FrequencyAnalyzer::getSpectrum before BandMapper)
+static void legacyBands(const std::vector<float>& spectrum, int bands, float* out) {
+    int binsPerBand = std::max(1, (int)spectrum.size() / bands);
+    for (int i = 0; i < bands; ++i) {
+        float sum = 0;
+        int count = 0;
+        int startBin = i * binsPerBand;
+        for (int j = 0; j < binsPerBand && (size_t)(startBin + j) < spectrum.size(); ++j) {
+            sum += spectrum[startBin + j];
+            count++;
+        }
+        out[i] = (count > 0) ? (sum / count) : 0.0f;
+    }
+}
+
+// Table build cost and per-spectrum mapping cost for each band layout
+static int benchBands(int fftSize) {
+    const int bands = 64;
+    const float sampleRate = 48000.0f;
+    const int iterations = 200000;
+    std::cout << "\n[bands] " << bands << " bands from fft " << fftSize << " @ " << (int)sampleRate << " Hz" << std::endl;
+
+    std::vector<float> spectrum(fftSize / 2), out(bands);
+    for (size_t k = 0; k < spectrum.size(); ++k) spectrum[k] = (float)((k * 7919) % 1000) / 1000.0f;
+
+    double start = cpuMs();
+    for (int i = 0; i < iterations; ++i) legacyBands(spectrum, bands, out.data());
+    double legacyUs = (cpuMs() - start) * 1000.0 / iterations;
+    std::cout << std::fixed << std::setprecision(3) << "  legacy       map " << std::setw(7) << legacyUs << " us" << std::endl;
+
+    const BandMapper::Layout layouts[] = { BandMapper::Layout::Linear, BandMapper::Layout::Log, BandMapper::Layout::Mel,
+                                           BandMapper::Layout::ThirdOctave, BandMapper::Layout::ConstantQ };
+    for (BandMapper::Layout layout : layouts) {
+        BandMapper mapper;
+        start = cpuMs();
+        mapper.build(layout, bands, fftSize, sampleRate);
+        double buildUs = (cpuMs() - start) * 1000.0;
+
+        out.assign(mapper.bands(), 0.0f);
+        start = cpuMs();
+        for (int i = 0; i < iterations; ++i) mapper.map(spectrum.data(), out.data());
+        double us = (cpuMs() - start) * 1000.0 / iterations;
+
+        std::cout << "  " << std::left << std::setw(12) << BandMapper::layoutName(layout) << std::right
+                  << " map " << std::setw(7) << us << " us, build " << std::setw(8) << buildUs << " us, "
+                  << mapper.bands() << " bands" << std::endl;
+    }
+    return 0;
+}
+
+static void showUsage() {
+    std::cout << "Usage:\n";
+    std::cout << "  abby-bench decode <track>       MP3 vs raw PCM PIRA playback cost\n";
+    std::cout << "  abby-bench convert <track>      Per-frame cost of decode/convert/resample stages\n";
+    std::cout << "  abby-bench dsp                  Per-block cost of volume ramp + EQ stage\n";
+    std::cout << "  abby-bench fft [size]           Legacy recursive FFT vs RealFft kernels\n";
+    std::cout << "  abby-bench bands [fftSize]      Band layout table build and mapping cost\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        showUsage();
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    if (mode == "decode" && argc >= 3) {
+        return benchDecode(argv[2]);
+    }
+    if (mode == "convert" && argc >= 3) {
+        return benchConvert(argv[2]);
+    }
+    if (mode == "dsp") {
+        return benchDsp();
+    }
+    if (mode == "fft") {
+        return benchFft(argc >= 3 ? std::atoi(argv[2]) : 0);
+    }
+    if (mode == "bands") {
+        int size = (argc >= 3) ? std::atoi(argv[2]) : 2048;
+        if (!RealFft::isValidSize(size)) {
+            showUsage();
+            return 1;
+        }
+        return benchBands(size);
+    }
+
+    showUsage();
+    return 1;
+}
@@ -2,26 +2,70 @@
 #include <vector>
 #include <string>
 #include "AbbyCrypt.hpp"
+#include "PcmDecoder.hpp"
+#include "TrackAnalysis.hpp"
 
 int main(int argc, char* argv[]) {
-    if (argc < 3) {
-        std::cout << "Usage: encrypt_util <input_file> <output_file> [hardware_id]\n";
+    // --pcm stores decoded PCM (PIRA v3) so low-CPU devices skip MP3 decoding
+    // --analysis embeds a precomputed spectrum/feature stream (PIRA v3) so they skip the live FFT too
+    bool pcmMode = false;
+    bool analysisMode = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--pcm") pcmMode = true;
+        else if (arg == "--analysis") analysisMode = true;
+        else args.push_back(arg);
+    }
+
+    if (args.size() < 2) {
+        std::cout << "Usage: encrypt_util [--pcm] [--analysis] <input_file> <output_file> [hardware_id]\n";
+        std::cout << "  --pcm        Decode to raw s16 PCM before encrypting (larger file, no decoding on device)\n";
+        std::cout << "  --analysis   Embed precomputed visualizer analysis (no live FFT on device)\n";
         return 1;
     }
 
-    std::string inputPath = argv[1];
-    std::string outputPath = argv[2];
+    std::string inputPath = args[0];
+    std::string outputPath = args[1];
     std::string hardwareId;
 
-    if (argc >= 4) {
-        hardwareId = argv[3];
+    if (args.size() >= 3) {
+        hardwareId = args[2];
     } else {
         hardwareId = Abby::AbbyCrypt::getHardwareSerial();
         std::cout << "Using local Hardware ID: " << hardwareId << std::endl;
     }
 
-    if (Abby::AbbyCrypt::encryptTrackFile(inputPath, outputPath, hardwareId)) {
-        std::cout << "Successfully encrypted " << inputPath << " to " << outputPath << " for ID: " << hardwareId << std::endl;
+    // Both modes need the decoded track; decode it once
+    std::vector<unsigned char> pcm;
+    unsigned channels = 0, sampleRate = 0;
+    if ((pcmMode || analysisMode) && !PcmDecoder::decodeFile(inputPath, pcm, channels, sampleRate)) {
+        std::cerr << "Failed to decode " << inputPath << std::endl;
+        return 1;
+    }
+    
+    std::vector<unsigned char> analysis;
+    if (analysisMode) {
+        auto track = TrackAnalysis::analyze(reinterpret_cast<const int16_t*>(pcm.data()),
+                                            pcm.size() / (2 * channels), channels, sampleRate);
+        if (!track) {
+            std::cerr << "Failed to analyse " << inputPath << std::endl;
+            return 1;
+        }
+        analysis = track->serialize();
+        std::cout << "Analysis: " << track->describe() << std::endl;
+    }
+
+    bool ok = false;
+    if (pcmMode) {
+        ok = Abby::AbbyCrypt::encryptPcmTrack(pcm, channels, sampleRate, outputPath, hardwareId, analysis);
+    } else {
+        ok = Abby::AbbyCrypt::encryptTrackFile(inputPath, outputPath, hardwareId, analysis);
+    }
+
+    if (ok) {
+        std::cout << "Successfully encrypted " << inputPath << " to " << outputPath << " for ID: " << hardwareId
+                  << (pcmMode ? " (PCM)" : "") << (analysisMode ? " (+analysis)" : "") << std::endl;
     } else {
         std::cerr << "Failed to encrypt file." << std::endl;
         return 1;
@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <csignal>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -11,10 +13,12 @@
 #include <memory>
 #include <atomic>
 #include <fstream>
+#include <sstream>
 
 #include "AbbyCrypt.hpp"
 #include "AudioPlayer.hpp"
 #include "ShaderVisualizer.hpp"
+#include "Realtime.hpp"
 #include "AbbyClient.hpp"
 
 #define SOCKET_PATH "/tmp/abby.sock"
@@ -80,6 +84,8 @@ std::atomic<bool> g_startVisualsRequested{false};
 std::atomic<bool> g_visualsActive{false};
 
 void runSocketServer(AudioPlayer& player) {
+    Realtime::applyToCurrentThread(Realtime::Role::Ipc);
+
     int server_fd;
     struct sockaddr_un address;
 
@@ -174,13 +180,80 @@ void runSocketServer(AudioPlayer& player) {
                     response = "OK\n";
                 } else if (msg == "volume") {
                     response = std::to_string((int)(player.getVolume() * 100)) + "%\n";
+                } else if (msg == "eq clear") {
+                    player.getDsp().clearEq();
+                } else if (msg.rfind("eq ", 0) == 0) {
+                    // eq <band> <freqHz> <gainDb> [q]
+                    std::istringstream args(msg.substr(3));
+                    int band;
+                    float freq, gain, q;
+                    if (!(args >> band >> freq >> gain)) {
+                        response = "ERROR: Usage: eq <band> <freqHz> <gainDb> [q]\n";
+                    } else {
+                        if (!(args >> q)) q = 1.0f;
+                        if (!player.getDsp().setBand(band, freq, gain, q)) {
+                            response = "ERROR: Invalid band (0-" + std::to_string(AudioDsp::MAX_BANDS - 1) + ")\n";
+                        }
+                    }
+                } else if (msg == "replaygain" || msg.rfind("replaygain ", 0) == 0) {
+                    std::string arg = msg.size() > 11 ? msg.substr(11) : "";
+                    float db = 0.0f;
+                    if (arg == "auto") {
+                        player.setReplayGainAuto();
+                    } else if (!arg.empty() && arg != "off" && !(std::istringstream(arg) >> db)) {
+                        response = "ERROR: Usage: replaygain [<dB>|off|auto]\n";
+                    } else if (!arg.empty()) {
+                        player.setReplayGain(db);
+                    }
+                    if (response == "OK\n") response = player.getReplayGainInfo() + "\n";
+                } else if (msg == "dsp") {
+                    response = player.getDsp().describe() + "\n";
                 } else if (msg == "status") {
                     response = player.getStatus() + "\n";
-                } else if (msg.rfind("shader", 0) == 0) {
+                } else if (msg == "history" || msg.rfind("history ", 0) == 0) {
+                    if (msg.size() > 8) {
+                        try {
+                            player.setHistorySeconds(std::stof(msg.substr(8)));
+                            response = "History window set to " + std::to_string((int)player.getHistorySeconds()) +
+                                       " s (applies from the next track)\n";
+                        } catch (...) {
+                            response = "ERROR: Usage: history [seconds]\n";
+                        }
+                    } else {
+                        response = player.getHistoryInfo() + "\n";
+                    }
+                } else if (msg == "analyzer" || msg.rfind("analyzer ", 0) == 0) {
+                    // analyzer [layout <name> | fft <size> | overlap <0-0.95> | hop <frames> | delay <ms>]
+                    std::istringstream args(msg.substr(8));
+                    std::string key, value;
+                    std::shared_ptr<FrequencyAnalyzer> analyzer = player.getAnalyzer();
+                    BandMapper::Layout layout;
+                    bool ok = true;
+                    if (args >> key >> value) {
+                        try {
+                            if (key == "layout" && BandMapper::parseLayout(value, layout)) analyzer->setLayout(layout);
+                            else if (key == "fft") ok = analyzer->setFftSize(std::stoi(value));
+                            else if (key == "overlap") ok = analyzer->setOverlap(std::stof(value));
+                            else if (key == "hop") ok = analyzer->setHopSize(std::stoi(value));
+                            else if (key == "delay") ok = analyzer->setDelayMs(std::stof(value));
+                            else ok = false;
+                        } catch (...) {
+                            ok = false;
+                        }
+                    } else if (!key.empty()) {
+                        ok = false;
+                    }
+                    response = ok ? analyzer->describe() + "\n"
+                                  : "ERROR: Usage: analyzer [layout linear|log|mel|third-octave|cq | fft <64-16384> | overlap <0-0.95> | hop <frames> | delay <-500-2000 ms>]\n";
+                } else if (msg == "realtime") {
+                    response = Realtime::report() + "\n";
+                } else if (msg == "output") {
+                    std::string info = player.getOutputInfo();
+                    response = (info.empty() ? "No output opened yet" : info) + "\n";
+                } else if (msg == "shader" || msg.rfind("shader ", 0) == 0) {
                     if (g_visuals && g_visualsActive) {
-                        std::string shaderCmd = msg.substr(7);
-                        g_visuals->handleShaderCommand(shaderCmd);
-                        response = "Shader command sent\n";
+                        std::string shaderCmd = msg.size() > 7 ? msg.substr(7) : "list";
+                        response = g_visuals->handleShaderCommand(shaderCmd) + "\n";
                     } else {
                         response = "ERROR: Visuals not running\n";
                     }
@@ -198,8 +271,44 @@ void runSocketServer(AudioPlayer& player) {
                     } else {
                         response = "Visuals not running\n";
                     }
+                } else if (msg.rfind("visuals target ", 0) == 0) {
+                    float ms = 0.0f;
+                    if (!(std::istringstream(msg.substr(15)) >> ms) || ms < 0.0f || ms > 100.0f) {
+                        response = "ERROR: Usage: visuals target <0-100 ms> (0 = always full resolution)\n";
+                    } else if (!g_visuals || !g_visualsActive) {
+                        response = "ERROR: Visuals not running\n";
+                    } else {
+                        g_visuals->setFrameTarget(ms);
+                        response = "Render target " + msg.substr(15) + " ms\n";
+                    }
+                } else if (msg.rfind("visuals fps ", 0) == 0) {
+                    std::istringstream args(msg.substr(12));
+                    float fps = 0.0f, idleFps = 10.0f;
+                    bool valid = (bool)(args >> fps) && fps >= 1.0f && fps <= 240.0f;
+                    if (valid && !(args >> std::ws).eof()) valid = (bool)(args >> idleFps) && idleFps >= 1.0f && idleFps <= fps;
+                    if (!valid) {
+                        response = "ERROR: Usage: visuals fps <1-240> [idle fps, default 10]\n";
+                    } else if (!g_visuals || !g_visualsActive) {
+                        response = "ERROR: Visuals not running\n";
+                    } else {
+                        g_visuals->setFrameRate(fps, idleFps);
+                        response = "Frame rate " + msg.substr(12) + " fps\n";
+                    }
+                } else if (msg.rfind("visuals quality ", 0) == 0) {
+                    std::string arg = msg.substr(16);
+                    int tier = -1;
+                    if (arg != "auto" && (!(std::istringstream(arg) >> tier) || tier < 0 ||
+                                          tier >= ShaderPreprocessor::QUALITY_TIERS)) {
+                        response = "ERROR: Usage: visuals quality <0-3|auto>\n";
+                    } else if (!g_visuals || !g_visualsActive) {
+                        response = "ERROR: Visuals not running\n";
+                    } else {
+                        g_visuals->setQuality(tier);
+                        response = "Shader quality " + arg + "\n";
+                    }
                 } else if (msg == "visuals status") {
-                    response = g_visualsActive ? "Visuals: RUNNING\n" : "Visuals: STOPPED\n";
+                    response = (g_visualsActive && g_visuals) ? "Visuals: RUNNING (" + g_visuals->getFrameStats() + ")\n"
+                                                              : "Visuals: STOPPED\n";
                 } else if (msg == "quit") {
                     g_running = false;
                     response = "SHUTTING DOWN\n";
@@ -226,6 +335,9 @@ void runHeadlessMode(AudioPlayer& player) {
     // Run socket server in BACKGROUND thread
     std::thread serverThread(runSocketServer, std::ref(player));
 
+    // The main thread only idles or renders visuals
+    Realtime::applyToCurrentThread(Realtime::Role::Render);
+
     // Run Visuals/Main Loop in MAIN thread
     while (g_running) {
         if (g_startVisualsRequested) {
@@ -259,7 +371,9 @@ void runHeadlessMode(AudioPlayer& player) {
 
 void showUsage() {
     std::cout << "Usage:\n";
-    std::cout << "  AbbyPlayer --daemon             Start daemon\n";
+    std::cout << "  AbbyPlayer --daemon [--realtime] Start daemon (realtime: FIFO priorities, pinning, mlock)\n";
+    std::cout << "  AbbyPlayer --bench-shaders [--frames N] [--size WxH] [--shader NAME] [--dump DIR] [--quality 0-3]\n";
+    std::cout << "                                  Time every shader offscreen (EGL), optionally save PPM frames\n";
     std::cout << "  AbbyPlayer play <file>          Play a file\n";
     std::cout << "  AbbyPlayer stop                 Stop playback\n";
     std::cout << "  AbbyPlayer pause                Pause playback\n";
@@ -267,7 +381,18 @@ void showUsage() {
     std::cout << "  AbbyPlayer seek <seconds>       Seek to position\n";
     std::cout << "  AbbyPlayer volume [0.0-1.0]     Set or get volume\n";
     std::cout << "  AbbyPlayer status               Get status\n";
-    std::cout << "  AbbyPlayer visuals <cmd>        start|stop|status\n";
+    std::cout << "  AbbyPlayer output               Show negotiated output format\n";
+    std::cout << "  AbbyPlayer eq <b> <hz> <db> [q] Set EQ band (0-7), 'eq clear' to reset\n";
+    std::cout << "  AbbyPlayer replaygain [dB|off|auto] Loudness gain: auto (default) levels tracks with\n";
+    std::cout << "                                  embedded analysis; a fixed dB (off = 0) applies to every track\n";
+    std::cout << "  AbbyPlayer dsp                  Show DSP settings and block cost\n";
+    std::cout << "  AbbyPlayer analyzer [key value] Show or set spectrum layout/fft/overlap/hop/delay\n";
+    std::cout << "  AbbyPlayer realtime             Show applied scheduling/memory settings\n";
+    std::cout << "  AbbyPlayer history [seconds]    Show seek history stats or set its window\n";
+    std::cout << "  AbbyPlayer visuals <cmd>        start|stop|status|target <ms> (render budget, 0 = off)\n";
+    std::cout << "                                  fps <n> [idle] (frame rate while playing / paused or silent)\n";
+    std::cout << "                                  quality <0-3|auto> (shader tier, auto follows the render budget)\n";
+    std::cout << "  AbbyPlayer shader [cmd]         next|prev|<name>, or list (measured cost per shader)\n";
     std::cout << "  AbbyPlayer quit                 Stop the daemon\n";
 }
 
@@ -283,10 +408,42 @@ int main(int argc, char* argv[]) {
     std::string arg1 = argv[1];
 
     if (arg1 == "--daemon") {
+        if (argc >= 3 && std::string(argv[2]) == "--realtime") {
+            Realtime::enable();
+        }
         AudioPlayer player;
         runHeadlessMode(player);
         player.stop();
     } 
+    else if (arg1 == "--bench-shaders") {
+        // Offscreen, no daemon: --bench-shaders [--frames N] [--size WxH] [--shader NAME] [--dump DIR] [--quality 0-3]
+        ShaderVisualizer::BenchOptions options;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--frames" && i + 1 < argc) options.frames = std::atoi(argv[++i]);
+            else if (arg == "--size" && i + 1 < argc) {
+                if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+                    options.width <= 0 || options.height <= 0) {
+                    std::cout << "Error: --size expects WIDTHxHEIGHT\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--shader" && i + 1 < argc) options.shader = argv[++i];
+            else if (arg == "--dump" && i + 1 < argc) options.dumpDir = argv[++i];
+            else if (arg == "--quality" && i + 1 < argc) {
+                options.quality = std::atoi(argv[++i]);
+                if (options.quality < 0 || options.quality >= ShaderPreprocessor::QUALITY_TIERS) {
+                    std::cout << "Error: --quality expects 0-3\n";
+                    return 1;
+                }
+            }
+            else {
+                std::cout << "Unknown option: " << arg << "\n";
+                return 1;
+            }
+        }
+        return ShaderVisualizer::runBenchmark(options);
+    }
     else if (arg1 == "play") {
         if (argc < 3) {
             std::cout << "Error: play requires a file path.\n";
@@ -320,14 +477,43 @@ int main(int argc, char* argv[]) {
     else if (arg1 == "status") {
         runClientMode("status");
     }
+    else if (arg1 == "output") {
+        runClientMode("output");
+    }
+    else if (arg1 == "eq") {
+        std::string cmd = "eq";
+        for (int i = 2; i < argc; ++i) cmd += " " + std::string(argv[i]);
+        runClientMode(cmd);
+    }
+    else if (arg1 == "replaygain") {
+        runClientMode(argc < 3 ? "replaygain" : "replaygain " + std::string(argv[2]));
+    }
+    else if (arg1 == "dsp") {
+        runClientMode("dsp");
+    }
+    else if (arg1 == "analyzer") {
+        std::string cmd = "analyzer";
+        for (int i = 2; i < argc; ++i) cmd += " " + std::string(argv[i]);
+        runClientMode(cmd);
+    }
+    else if (arg1 == "realtime") {
+        runClientMode("realtime");
+    }
+    else if (arg1 == "history") {
+        runClientMode(argc >= 3 ? "history " + std::string(argv[2]) : "history");
+    }
     else if (arg1 == "visuals") {
         if (argc < 3) {
-            std::cout << "Usage: AbbyPlayer visuals [start|stop|status]\n";
+            std::cout << "Usage: AbbyPlayer visuals [start|stop|status|target <ms>|fps <n> [idle]|quality <0-3|auto>]\n";
             return 1;
         }
-        std::string cmd = "visuals " + std::string(argv[2]);
+        std::string cmd = "visuals";
+        for (int i = 2; i < argc; ++i) cmd += " " + std::string(argv[i]);
         runClientMode(cmd);
     }
+    else if (arg1 == "shader") {
+        runClientMode(argc >= 3 ? "shader " + std::string(argv[2]) : "shader list");
+    }
     else if (arg1 == "quit") {
         runClientMode("quit");
     }
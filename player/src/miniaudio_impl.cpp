@@ -0,0 +1,4 @@
+// Single translation unit holding the miniaudio implementation so that
+// every target (player, tools) can share it.
+#define MINIAUDIO_IMPLEMENTATION
+#include "../include/miniaudio.h"
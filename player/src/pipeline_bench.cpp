@@ -0,0 +1,256 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <sys/resource.h>
+#include "../include/miniaudio.h"
+#include "AudioMixer.hpp"
+#include "AudioPlayer.hpp"
+
+// abby-pipeline-bench - whole playback path without a sound card:
+// PIRA read -> decrypt -> ds_read -> decode -> mixer callback -> analyzer -> DSP.
+// Offline mode pulls from the mixer as fast as possible (or paced to real
+// time with --realtime); --null-device lets miniaudio's null backend clock it.
+
+static const ma_uint32 BLOCK_FRAMES = 1024; // Typical device period
+
+struct Options {
+    std::string path;
+    std::string wavPath;
+    bool realtime = false;
+    bool nullDevice = false;
+    bool analyzer = false;     // Subscribe to the spectrum like the visualizer does
+    int seeks = 0;
+    float seekBack = 0.0f;     // > 0: seek back this far instead of to random positions
+    double maxSeconds = 0.0;
+};
+
+struct SeekResult {
+    int count = 0;
+    double minMs = 0.0, maxMs = 0.0, sumMs = 0.0;
+
+    void add(double ms) {
+        if (ms < 0) return;
+        minMs = (count == 0 || ms < minMs) ? ms : minMs;
+        maxMs = (count == 0 || ms > maxMs) ? ms : maxMs;
+        sumMs += ms;
+        count++;
+    }
+};
+
+static double processCpuMs() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000.0 +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000.0;
+}
+
+// Deterministic seek targets so --wav output stays comparable across runs. Seek 'index'
+// of 'count' lands early enough that the seeks after it, 'everySeconds' apart, still
+// come before the end of the track.
+static float seekTarget(int index, int count, float totalSeconds, float everySeconds) {
+    unsigned x = 2654435761u * (unsigned)(index + 1);
+    float room = std::max(0.0f, totalSeconds - everySeconds * (count - index));
+    return (float)((x >> 8) % 1000) / 1000.0f * room;
+}
+
+static void printStage(const char* name, uint64_t ns, double audioSeconds) {
+    double ms = ns / 1e6;
+    std::cout << "    " << std::left << std::setw(8) << name << std::right
+              << std::setw(10) << ms << " ms"
+              << std::setw(10) << (audioSeconds > 0 ? ms / audioSeconds : 0.0) << " ms / s audio" << std::endl;
+}
+
+static int run(const Options& opt) {
+    AudioMixer::Mode mode = opt.nullDevice ? AudioMixer::Mode::NullDevice : AudioMixer::Mode::Offline;
+    auto mixer = std::make_shared<AudioMixer>(mode);
+    AudioPlayer player(mixer);
+    if (opt.analyzer) player.getAnalyzer()->acquire();
+
+    double cpuStart = processCpuMs();
+    auto wallStart = std::chrono::steady_clock::now();
+
+    player.play(opt.path);
+    if (!player.getPlaybackState().isPlaying) {
+        std::cerr << "[Bench] Failed to start playback of " << opt.path << std::endl;
+        return 1;
+    }
+
+    AudioMixer::Format format = mixer->getFormat();
+    // Decoder length, not the chunk-count estimate: MP3 chunks are not seconds
+    float totalSeconds = (float)player.getLengthSeconds();
+    // Without --seconds run to the end of the track
+    double limit = (opt.maxSeconds > 0) ? opt.maxSeconds : 1e9;
+    ma_uint64 limitFrames = (ma_uint64)(limit * format.sampleRate);
+
+    // Seeks are spread evenly over the rendered range, in rendered audio
+    double seekRange = (opt.maxSeconds > 0) ? std::min(opt.maxSeconds, (double)totalSeconds) : totalSeconds;
+    ma_uint64 seekEvery = (opt.seeks > 0) ? (ma_uint64)(seekRange * format.sampleRate) / (opt.seeks + 1) : 0;
+    float seekEverySeconds = (float)seekEvery / format.sampleRate;
+    int seeksDone = 0;
+    SeekResult seekResult;
+
+    ma_encoder encoder;
+    bool writeWav = !opt.wavPath.empty();
+    if (writeWav) {
+        ma_encoder_config cfg = ma_encoder_config_init(ma_encoding_format_wav, format.format, format.channels, format.sampleRate);
+        if (ma_encoder_init_file(opt.wavPath.c_str(), &cfg, &encoder) != MA_SUCCESS) {
+            std::cerr << "[Bench] Cannot write " << opt.wavPath << std::endl;
+            return 1;
+        }
+    }
+
+    ma_uint64 rendered = 0;
+    if (!opt.nullDevice) {
+        std::vector<unsigned char> block(BLOCK_FRAMES * ma_get_bytes_per_frame(format.format, format.channels));
+        auto blockTime = std::chrono::nanoseconds((long long)BLOCK_FRAMES * 1000000000ll / format.sampleRate);
+        auto next = std::chrono::steady_clock::now();
+        bool awaitingSeek = false;
+
+        while (rendered < limitFrames && !player.getPipelineStats().finished) {
+            if (seekEvery > 0 && seeksDone < opt.seeks && rendered >= seekEvery * (seeksDone + 1)) {
+                float position = player.getPlaybackState().currentTime;
+                player.seek(opt.seekBack > 0 ? std::max(0.0f, position - opt.seekBack)
+                                             : seekTarget(seeksDone, opt.seeks, totalSeconds, seekEverySeconds));
+                seeksDone++;
+                awaitingSeek = true;
+            }
+
+            mixer->render(block.data(), BLOCK_FRAMES);
+            if (writeWav) ma_encoder_write_pcm_frames(&encoder, block.data(), BLOCK_FRAMES, NULL);
+            rendered += BLOCK_FRAMES;
+
+            if (awaitingSeek) {
+                seekResult.add(player.getPipelineStats().lastSeekMs);
+                awaitingSeek = false;
+            }
+            if (opt.realtime) {
+                next += blockTime;
+                std::this_thread::sleep_until(next);
+            }
+        }
+    } else {
+        // The null device renders on its own thread; poll its progress
+        auto start = std::chrono::steady_clock::now();
+        while (!player.getPipelineStats().finished) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= limit) break;
+
+            if (seekEvery > 0 && seeksDone < opt.seeks &&
+                elapsed * format.sampleRate >= (double)(seekEvery * (seeksDone + 1))) {
+                double before = player.getPipelineStats().lastSeekMs;
+                float position = player.getPlaybackState().currentTime;
+                player.seek(opt.seekBack > 0 ? std::max(0.0f, position - opt.seekBack)
+                                             : seekTarget(seeksDone, opt.seeks, totalSeconds, seekEverySeconds));
+                seeksDone++;
+                for (int i = 0; i < 2000 && player.getPipelineStats().lastSeekMs == before; ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                seekResult.add(player.getPipelineStats().lastSeekMs);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    // Snapshot before stop() so teardown is not counted
+    AudioPlayer::PipelineStats stats = player.getPipelineStats();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double cpuMs = processCpuMs() - cpuStart;
+    std::string outputInfo = mixer->getOutputInfo();
+    std::string historyInfo = player.getHistoryInfo();
+    FrequencyAnalyzer::Stats analysis = player.getAnalyzer()->getStats();
+    std::string analyzerInfo = player.getAnalyzer()->describe();
+    if (opt.analyzer) player.getAnalyzer()->release();
+    player.stop();
+    if (writeWav) ma_encoder_uninit(&encoder);
+
+    double audioSeconds = (double)stats.framesRendered / format.sampleRate;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "abby-pipeline-bench: " << opt.path << " ("
+              << (opt.nullDevice ? "null device" : opt.realtime ? "offline, real-time paced" : "offline, as fast as possible")
+              << ")" << std::endl;
+    std::cout << "  Output:      " << outputInfo << std::endl;
+    std::cout << "  Rendered:    " << audioSeconds << " s audio in " << wallSeconds << " s wall => "
+              << (wallSeconds > 0 ? stats.framesRendered / wallSeconds : 0.0) << " frames/s ("
+              << (wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0) << "x real time)"
+              << (stats.finished ? ", track complete" : "") << std::endl;
+    std::cout << "  Track:       " << totalSeconds << " s" << std::endl;
+    std::cout << "  First audio: " << stats.firstAudioMs << " ms after play()" << std::endl;
+    if (opt.seeks > 0) {
+        std::cout << "  Seeks:       " << seeksDone << " of " << opt.seeks << " done";
+        if (seekResult.count > 0) {
+            std::cout << ", latency min/avg/max " << seekResult.minMs << " / "
+                      << seekResult.sumMs / seekResult.count << " / " << seekResult.maxMs << " ms";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  " << historyInfo << std::endl;
+    std::cout << "  Underruns:   " << stats.underruns << " (" << stats.underrunFrames << " frames) in "
+              << stats.callbacks << " callbacks" << std::endl;
+    std::cout << "  Process CPU: " << cpuMs << " ms (" << (audioSeconds > 0 ? cpuMs / audioSeconds / 10.0 : 0.0)
+              << "% of one core at real time)" << std::endl;
+    std::cout << "  Per stage (decrypt " << stats.decryptChunks << " chunks):" << std::endl;
+    printStage("decrypt", stats.decryptNs, audioSeconds);
+    printStage("read", stats.readNs, audioSeconds);
+    printStage("decode", stats.decodeNs, audioSeconds);
+    printStage("convert", stats.convertNs, audioSeconds);
+    printStage("tap", stats.analyzeNs, audioSeconds);
+    printStage("dsp", stats.dspNs, audioSeconds);
+    if (opt.analyzer) {
+        printStage("spectra", analysis.analysisNs, audioSeconds);
+        std::cout << "    " << analysis.spectra << " spectra on the analysis thread, "
+                  << analysis.droppedSamples << " samples dropped at the tap, "
+                  << analysis.skippedSamples << " skipped to catch up" << std::endl;
+        std::cout << "    " << analyzerInfo << std::endl;
+    }
+    if (writeWav) {
+        std::cout << "  Wrote " << opt.wavPath << std::endl;
+    }
+    return 0;
+}
+
+static void showUsage() {
+    std::cout << "Usage: abby-pipeline-bench <file.pira> [options]\n";
+    std::cout << "  --realtime        Pace the offline render to the audio clock\n";
+    std::cout << "  --null-device     Render on miniaudio's null backend instead (real-time)\n";
+    std::cout << "  --analyzer        Run spectrum analysis as if the visualizer were open\n";
+    std::cout << "  --seeks <n>       Seek n times, evenly spread, to fixed pseudo-random positions\n";
+    std::cout << "  --seek-back <s>   Make those seeks jump back s seconds (history hits)\n";
+    std::cout << "  --seconds <s>     Stop after s seconds of audio\n";
+    std::cout << "  --wav <out.wav>   Write the rendered output (offline only)\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        showUsage();
+        return 1;
+    }
+
+    Options opt;
+    opt.path = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--realtime") opt.realtime = true;
+        else if (arg == "--null-device") opt.nullDevice = true;
+        else if (arg == "--analyzer") opt.analyzer = true;
+        else if (arg == "--seeks" && i + 1 < argc) opt.seeks = std::atoi(argv[++i]);
+        else if (arg == "--seek-back" && i + 1 < argc) opt.seekBack = (float)std::atof(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc) opt.maxSeconds = std::atof(argv[++i]);
+        else if (arg == "--wav" && i + 1 < argc) opt.wavPath = argv[++i];
+        else {
+            showUsage();
+            return 1;
+        }
+    }
+    if (opt.nullDevice && !opt.wavPath.empty()) {
+        std::cerr << "--wav needs the offline renderer" << std::endl;
+        return 1;
+    }
+
+    return run(opt);
+}
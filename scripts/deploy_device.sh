@@ -319,7 +319,8 @@ for file in "$SOURCE_AUDIO_DIR"/*; do
                 outfile="$AUDIO_DIR/${filename_noext}.pira"
                 echo "Encrypting: $filename -> ${filename_noext}.pira"
                 
-                if "$ENCRYPT_TOOL" "$file" "$outfile"; then
+                # --analysis: precomputed visualizer data, the device skips the live FFT
+                if "$ENCRYPT_TOOL" --analysis "$file" "$outfile"; then
                     COUNT=$((COUNT+1))
                 else
                     echo "ERROR: Failed to encrypt $filename"